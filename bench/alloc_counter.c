@@ -0,0 +1,41 @@
+/* Counts heap allocations made by the process, for bench/bench_prompt_build.gd.
+ *
+ * Build and run with:
+ *   cc -shared -fPIC -O2 -o bench/alloc_counter.so bench/alloc_counter.c
+ *   LD_PRELOAD=$PWD/bench/alloc_counter.so godot --headless --script bench/bench_prompt_build.gd
+ *
+ * AIBenchmark looks up ai_alloc_count() at runtime and reports -1 when this is not preloaded.
+ * The counter is per thread, so allocations made by worker threads during a measurement are not
+ * attributed to it.
+ */
+#include <stddef.h>
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+static __thread unsigned long long allocations __attribute__((tls_model("initial-exec")));
+
+unsigned long long ai_alloc_count(void) {
+    return allocations;
+}
+
+void *malloc(size_t size) {
+    allocations++;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    allocations++;
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    allocations++;
+    return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr) {
+    __libc_free(ptr);
+}
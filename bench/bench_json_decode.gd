@@ -0,0 +1,13 @@
+# Compares AIJsonReader against JSON.parse_string on completion responses of growing size.
+#
+# Run with: godot --headless --script bench/bench_json_decode.gd
+extends SceneTree
+
+
+func _init():
+	var bench = ClassDB.instantiate("AIBenchmark")
+	for content_length in [256, 4096, 65536]:
+		var iterations = max(50, 2000000 / content_length)
+		var result = bench.benchmark_json_decode(iterations, content_length)
+		print(JSON.stringify(result))
+	quit()
@@ -0,0 +1,14 @@
+# Compares building a chat request the old way (String concatenation, a Variant tree and
+# JSON.stringify) against AIPayloadWriter, per turn.
+#
+# Run with: godot --headless --script bench/bench_prompt_build.gd
+# Preload bench/alloc_counter.so (see the comment in alloc_counter.c) to also count allocations.
+extends SceneTree
+
+
+func _init():
+	var bench = ClassDB.instantiate("AIBenchmark")
+	for history_turns in [0, 5, 20]:
+		var result = bench.benchmark_prompt_build(2000, history_turns, 5)
+		print(JSON.stringify(result))
+	quit()
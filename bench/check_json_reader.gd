@@ -0,0 +1,14 @@
+# Runs AIJsonReader against escapes, surrogate pairs, skipped nested values, missing or
+# non-string fields and every truncation of a response. Exits with 1 if any check fails.
+#
+# Run with: godot --headless --script bench/check_json_reader.gd
+extends SceneTree
+
+
+func _init():
+	var bench = ClassDB.instantiate("AIBenchmark")
+	var result = bench.check_json_reader()
+	for failure in result["failures"]:
+		printerr(failure)
+	print("%d checks, %d failed" % [result["checks"], result["failures"].size()])
+	quit(1 if result["failures"].size() > 0 else 0)
@@ -0,0 +1,123 @@
+# Drives complete assistant turns through ChatDock, or multi-file tasks through ComposerDock with
+# --dock=composer, against the mock completion server.
+#
+# Normally started by bench/run_e2e_bench.py, which launches the mock server and sets
+# GODOT_AI_ENDPOINT. Run manually with:
+#   GODOT_AI_ENDPOINT=http://127.0.0.1:8011/v1/chat/completions OPENAI_API_KEY=mock \
+#       godot --headless --script bench/e2e_bench.gd -- --turns=20
+extends SceneTree
+
+const STALL_MSEC = 50.0
+
+var turns = 20
+var turn_timeout_msec = 30000
+var dock_name = "chat"
+var prompts = [
+	"How do I connect a signal to a method in GDScript?",
+	"What is the difference between _process and _physics_process?",
+	"How can I move a CharacterBody2D with move_and_slide?",
+	"How do I load a resource at runtime?",
+	"Explain how Tween works in Godot 4.",
+]
+
+var dock
+var bench
+var completed = 0
+var timed_out = 0
+var turn_started_msec = 0
+# Turns submitted and finish signals seen. The dock finishes turns in the order they were
+# submitted, so the n-th signal belongs to turn n, even if that turn was given up as timed out.
+var submitted_turns = 0
+var finished_turns = 0
+var turn_times_msec = []
+var waiting = false
+var last_frame_usec = 0
+var max_frame_msec = 0.0
+var stalls = 0
+
+
+func _init():
+	for arg in OS.get_cmdline_user_args():
+		if arg.begins_with("--turns="):
+			turns = int(arg.get_slice("=", 1))
+		elif arg.begins_with("--turn-timeout-msec="):
+			turn_timeout_msec = int(arg.get_slice("=", 1))
+		elif arg.begins_with("--dock="):
+			dock_name = arg.get_slice("=", 1)
+
+	bench = ClassDB.instantiate("AIBenchmark")
+	bench.reset_trace()
+
+	if dock_name == "composer":
+		dock = ClassDB.instantiate("ComposerDock")
+		dock.connect("task_finished", _on_turn_finished)
+	else:
+		dock = ClassDB.instantiate("ChatDock")
+		dock.connect("turn_finished", _on_turn_finished)
+	root.add_child(dock)
+
+
+func _process(_delta):
+	var now = Time.get_ticks_usec()
+	if last_frame_usec > 0:
+		var frame_msec = (now - last_frame_usec) / 1000.0
+		max_frame_msec = max(max_frame_msec, frame_msec)
+		if frame_msec > STALL_MSEC:
+			stalls += 1
+	last_frame_usec = now
+
+	if waiting:
+		if Time.get_ticks_msec() - turn_started_msec > turn_timeout_msec:
+			timed_out += 1
+			waiting = false
+		else:
+			return false
+
+	if completed + timed_out >= turns:
+		_finish()
+		return true
+
+	if dock_name == "composer" and finished_turns < submitted_turns:
+		# ComposerDock drops a task sent while another is still running, so a timed-out task is
+		# waited out first. Every further timeout spent waiting uses up a turn.
+		if Time.get_ticks_msec() - turn_started_msec > turn_timeout_msec:
+			timed_out += 1
+			turn_started_msec = Time.get_ticks_msec()
+		return false
+
+	waiting = true
+	turn_started_msec = Time.get_ticks_msec()
+	submitted_turns += 1
+	var prompt = prompts[(completed + timed_out) % prompts.size()]
+	if dock_name == "composer":
+		dock.submit_task(prompt)
+	else:
+		dock.submit_message(prompt)
+	return false
+
+
+func _on_turn_finished():
+	var turn = finished_turns
+	finished_turns += 1
+	# A late signal from a timed-out turn must not count as the current turn's completion.
+	if not waiting or turn != submitted_turns - 1:
+		return
+	waiting = false
+	completed += 1
+	turn_times_msec.append(Time.get_ticks_msec() - turn_started_msec)
+
+
+func _finish():
+	var result = {
+		"dock": dock_name,
+		"turns": turns,
+		"completed": completed,
+		"timed_out": timed_out,
+		"turn_msec": turn_times_msec,
+		"frame_stalls": stalls,
+		"max_frame_msec": max_frame_msec,
+		"trace": bench.get_trace_summary(),
+	}
+	# The runner picks this line out of the engine output.
+	print("E2E_RESULT " + JSON.stringify(result))
+	quit()
@@ -0,0 +1,263 @@
+"""
+Local stand-in for an OpenAI-compatible chat completions endpoint.
+
+Used by the end-to-end benchmark so that assistant turns can be measured without network
+variance or API cost. Replies are deterministic for a given --seed, latency and token rate are
+configurable, and 429s (with Retry-After) and dropped connections can be injected to exercise the
+retry path.
+
+Endpoints:
+    POST /v1/chat/completions   Completion; honours "stream": true with server-sent events and
+                                accepts gzip request bodies (Content-Encoding: gzip).
+    GET  /stats                 Request, byte and status counters as JSON.
+    POST /reset                 Clears the counters.
+
+Usage:
+    python bench/mock_llm_server.py --port 8011 --latency-ms 200 --tokens-per-sec 80
+"""
+
+import argparse
+import gzip
+import json
+import random
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+WORDS = (
+    "node scene signal export resource physics process ready input vector transform "
+    "tween shader material camera viewport animation collision body area script"
+).split()
+
+
+class Stats:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.reset()
+
+    def reset(self):
+        with self.lock:
+            self.requests = 0
+            self.completions = 0
+            self.classifier_requests = 0
+            self.plan_requests = 0
+            self.bytes_received = 0
+            self.bytes_decoded = 0
+            self.compressed_requests = 0
+            self.bytes_sent = 0
+            self.rate_limited = 0
+            self.dropped = 0
+
+    def as_dict(self):
+        with self.lock:
+            return {
+                "requests": self.requests,
+                "completions": self.completions,
+                "classifier_requests": self.classifier_requests,
+                "plan_requests": self.plan_requests,
+                "bytes_received": self.bytes_received,
+                "bytes_decoded": self.bytes_decoded,
+                "compressed_requests": self.compressed_requests,
+                "bytes_sent": self.bytes_sent,
+                "rate_limited": self.rate_limited,
+                "dropped": self.dropped,
+            }
+
+
+class MockHandler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+
+    def log_message(self, format, *args):
+        if self.server.options.verbose:
+            super().log_message(format, *args)
+
+    def _send_json(self, status, payload, headers=None):
+        body = json.dumps(payload).encode("utf-8")
+        self.send_response(status)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(body)))
+        for name, value in (headers or {}).items():
+            self.send_header(name, value)
+        self.end_headers()
+        self.wfile.write(body)
+        with self.server.stats.lock:
+            self.server.stats.bytes_sent += len(body)
+
+    def _rate_limit_headers(self):
+        return {
+            "x-ratelimit-limit-requests": "500",
+            "x-ratelimit-remaining-requests": "499",
+            "x-ratelimit-reset-requests": "120ms",
+            "x-ratelimit-limit-tokens": "200000",
+            "x-ratelimit-remaining-tokens": "199000",
+            "x-ratelimit-reset-tokens": "300ms",
+        }
+
+    def do_GET(self):
+        if self.path == "/stats":
+            self._send_json(200, self.server.stats.as_dict())
+        else:
+            self._send_json(404, {"error": {"message": "Not found"}})
+
+    def do_POST(self):
+        length = int(self.headers.get("Content-Length", 0))
+        raw = self.rfile.read(length)
+        stats = self.server.stats
+
+        if self.path == "/reset":
+            stats.reset()
+            self._send_json(200, {})
+            return
+        if self.path != "/v1/chat/completions":
+            self._send_json(404, {"error": {"message": "Not found"}})
+            return
+
+        options = self.server.options
+        compressed = self.headers.get("Content-Encoding", "").lower() == "gzip"
+        try:
+            decoded = gzip.decompress(raw) if compressed else raw
+        except OSError:
+            self._send_json(400, {"error": {"message": "Invalid gzip body"}})
+            return
+
+        with stats.lock:
+            stats.requests += 1
+            stats.bytes_received += len(raw)
+            stats.bytes_decoded += len(decoded)
+            stats.compressed_requests += 1 if compressed else 0
+            roll = self.server.rng.random()
+
+        try:
+            request = json.loads(decoded.decode("utf-8"))
+        except ValueError:
+            self._send_json(400, {"error": {"message": "Invalid JSON body"}})
+            return
+
+        if roll < options.drop_rate:
+            with stats.lock:
+                stats.dropped += 1
+            self.close_connection = True
+            self.connection.close()
+            return
+        if roll < options.drop_rate + options.rate_429:
+            with stats.lock:
+                stats.rate_limited += 1
+            self._send_json(429, {"error": {"message": "Rate limit reached"}},
+                            {"Retry-After-ms": str(options.retry_after_ms)})
+            return
+
+        messages = request.get("messages", [])
+        system = " ".join(m.get("content", "") for m in messages if m.get("role") == "system")
+        if "classifier" in system.lower():
+            with stats.lock:
+                stats.classifier_requests += 1
+            time.sleep(options.latency_ms / 1000.0)
+            self._send_json(200, self._completion(request, "true"), self._rate_limit_headers())
+            return
+        if "plan code changes" in system.lower():
+            # Composer planning: one subtask per file, answered like any other short request.
+            with stats.lock:
+                stats.plan_requests += 1
+            files = [{"path": f"res://mock/file_{i}.gd", "instructions": "Add a helper function."}
+                     for i in range(options.plan_files)]
+            time.sleep(options.latency_ms / 1000.0)
+            self._send_json(200, self._completion(request, json.dumps({"files": files})), self._rate_limit_headers())
+            return
+        edits_file = "edit one file" in system.lower()
+
+        with stats.lock:
+            stats.completions += 1
+            seed = options.seed + stats.completions
+        rng = random.Random(seed)
+        tokens = [rng.choice(WORDS) for _ in range(options.reply_tokens)]
+
+        time.sleep(options.latency_ms / 1000.0)
+        if request.get("stream"):
+            self._stream(request, tokens)
+        else:
+            time.sleep(len(tokens) / max(options.tokens_per_sec, 1e-3))
+            content = " ".join(tokens)
+            if edits_file:
+                content = "```gdscript\nextends Node\n\n# " + content + "\n```"
+            self._send_json(200, self._completion(request, content), self._rate_limit_headers())
+
+    def _completion(self, request, content):
+        return {
+            "id": "chatcmpl-mock",
+            "object": "chat.completion",
+            "model": request.get("model", "mock"),
+            "choices": [{"index": 0, "message": {"role": "assistant", "content": content}, "finish_reason": "stop"}],
+            "usage": {"prompt_tokens": 0, "completion_tokens": len(content.split()), "total_tokens": 0},
+        }
+
+    def _stream(self, request, tokens):
+        self.send_response(200)
+        self.send_header("Content-Type", "text/event-stream")
+        self.send_header("Transfer-Encoding", "chunked")
+        for name, value in self._rate_limit_headers().items():
+            self.send_header(name, value)
+        self.end_headers()
+
+        delay = 1.0 / max(self.server.options.tokens_per_sec, 1e-3)
+        sent = 0
+        for i, token in enumerate(tokens):
+            chunk = {
+                "id": "chatcmpl-mock",
+                "object": "chat.completion.chunk",
+                "model": request.get("model", "mock"),
+                "choices": [{"index": 0, "delta": {"content": (" " if i else "") + token}, "finish_reason": None}],
+            }
+            sent += self._write_chunk("data: " + json.dumps(chunk) + "\n\n")
+            time.sleep(delay)
+        sent += self._write_chunk("data: [DONE]\n\n")
+        self.wfile.write(b"0\r\n\r\n")
+        with self.server.stats.lock:
+            self.server.stats.bytes_sent += sent
+
+    def _write_chunk(self, text):
+        data = text.encode("utf-8")
+        self.wfile.write(b"%x\r\n%s\r\n" % (len(data), data))
+        self.wfile.flush()
+        return len(data)
+
+
+def create_server(options):
+    server = ThreadingHTTPServer((options.host, options.port), MockHandler)
+    server.daemon_threads = True
+    server.options = options
+    server.stats = Stats()
+    server.rng = random.Random(options.seed)
+    return server
+
+
+def build_parser():
+    parser = argparse.ArgumentParser(description="Mock OpenAI-compatible completion server.")
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=8011, help="0 picks a free port")
+    parser.add_argument("--latency-ms", type=float, default=200.0, help="Delay before the first token")
+    parser.add_argument("--tokens-per-sec", type=float, default=80.0)
+    parser.add_argument("--reply-tokens", type=int, default=120)
+    parser.add_argument("--rate-429", type=float, default=0.0, help="Fraction of requests answered with 429")
+    parser.add_argument("--retry-after-ms", type=int, default=250)
+    parser.add_argument("--drop-rate", type=float, default=0.0, help="Fraction of connections closed without a reply")
+    parser.add_argument("--plan-files", type=int, default=4, help="Files in each composer plan")
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--verbose", action="store_true")
+    return parser
+
+
+def main():
+    options = build_parser().parse_args()
+    server = create_server(options)
+    # The runner reads the bound port from this line.
+    print(f"MOCK_LLM_LISTENING {server.server_address[1]}", flush=True)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        server.server_close()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,318 @@
+"""
+Retrieval quality and speed benchmark for the Godot documentation index.
+
+Runs the labelled queries in retrieval_queries.json against each retrieval backend and reports
+recall@k, MRR, query latency percentiles, index load time and memory as JSON. With --baseline the
+run is compared against an earlier result and the script exits with status 1 on a regression.
+
+Queries are labelled with the documentation sections that answer them, and a retrieved chunk only
+counts when its "section" metadata is one of them. create_embeddings.py records that metadata, so
+a store built before it did has to be rebuilt.
+
+Backends:
+    chroma      The production path: GodotDocsRetriever.search() on the Chroma store.
+    bruteforce  Exact cosine similarity over all chunk embeddings (float32 matrix).
+    batch       GodotDocsRetriever.search_batch(), the blocked kernel behind multi-query expansion.
+    quantized   Same as bruteforce with int8 embeddings and per-vector scales.
+    ann         Inverted-file index: k-means clusters, only the nearest clusters are scanned.
+    hybrid      BM25 keyword ranking fused with bruteforce through reciprocal rank fusion.
+
+Usage:
+    python bench/retrieval_bench.py --k 5 --output bench_output.json
+    python bench/retrieval_bench.py --baseline bench_output.json
+"""
+
+import argparse
+import json
+import math
+import os
+import re
+import sys
+import time
+from collections import Counter
+from typing import Callable, Dict, List
+
+import numpy as np
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from godot_docs_retriever import GodotDocsRetriever
+
+BENCH_DIR = os.path.dirname(os.path.abspath(__file__))
+
+
+def rss_mb() -> float:
+    """Current resident set size of this process in MiB."""
+    try:
+        with open("/proc/self/status") as status:
+            for line in status:
+                if line.startswith("VmRSS:"):
+                    return int(line.split()[1]) / 1024.0
+    except OSError:
+        pass
+    import resource
+    return resource.getrusage(resource.RUSAGE_SELF).ru_maxrss / 1024.0
+
+
+def percentile(values: List[float], p: float) -> float:
+    if not values:
+        return 0.0
+    ordered = sorted(values)
+    index = min(len(ordered) - 1, max(0, int(math.ceil(p / 100.0 * len(ordered))) - 1))
+    return ordered[index]
+
+
+def tokenize(text: str) -> List[str]:
+    return re.findall(r"[a-z0-9_@]+", text.lower())
+
+
+class Corpus:
+    """All chunks and their embeddings, pulled out of the Chroma store once."""
+
+    def __init__(self, retriever: GodotDocsRetriever):
+        data = retriever.vectorstore._collection.get(include=["embeddings", "documents", "metadatas"])
+        self.documents: List[str] = data["documents"]
+        self.sections: List[str] = [(metadata or {}).get("section", "") for metadata in data["metadatas"]]
+        # Backends that return chunk text are mapped back to the chunk it came from.
+        self.index_of: Dict[str, int] = {}
+        for i, document in enumerate(self.documents):
+            self.index_of.setdefault(document, i)
+        matrix = np.asarray(data["embeddings"], dtype=np.float32)
+        norms = np.linalg.norm(matrix, axis=1, keepdims=True)
+        self.matrix = matrix / np.maximum(norms, 1e-12)
+        self.embed = retriever.embeddings.embed_query
+
+    def embed_query(self, query: str) -> np.ndarray:
+        vector = np.asarray(self.embed(query), dtype=np.float32)
+        return vector / max(float(np.linalg.norm(vector)), 1e-12)
+
+
+def top_k(scores: np.ndarray, k: int) -> np.ndarray:
+    k = min(k, scores.shape[0])
+    candidates = np.argpartition(-scores, k - 1)[:k]
+    return candidates[np.argsort(-scores[candidates])]
+
+
+def build_chroma(retriever: GodotDocsRetriever, corpus: Corpus) -> Callable[[str, int], List[int]]:
+    def search(query: str, k: int) -> List[int]:
+        return [corpus.index_of.get(r["content"], -1) for r in retriever.search(query, k)]
+    return search
+
+
+def build_bruteforce(retriever: GodotDocsRetriever, corpus: Corpus) -> Callable[[str, int], List[int]]:
+    matrix = corpus.matrix.copy()
+
+    def search(query: str, k: int) -> List[int]:
+        scores = matrix @ corpus.embed_query(query)
+        return list(top_k(scores, k))
+    return search
+
+
+def build_batch(retriever: GodotDocsRetriever, corpus: Corpus) -> Callable[[str, int], List[int]]:
+    # A retriever of its own: once its matrix is loaded search() takes the matrix path too, and
+    # the shared one has to keep measuring the store for "chroma". Without a matrix search_batch()
+    # would fall back to the store itself.
+    batch_retriever = GodotDocsRetriever(persist_directory=retriever.persist_directory, snapshot_directory="")
+    batch_retriever._embeddings = retriever.embeddings
+    batch_retriever._load_matrix()
+
+    def search(query: str, k: int) -> List[int]:
+        return [corpus.index_of.get(r["content"], -1) for r in batch_retriever.search_batch([query], k)[0]]
+    return search
+
+
+def build_quantized(retriever: GodotDocsRetriever, corpus: Corpus) -> Callable[[str, int], List[int]]:
+    scales = np.maximum(np.abs(corpus.matrix).max(axis=1), 1e-12) / 127.0
+    quantized = np.round(corpus.matrix / scales[:, None]).astype(np.int8)
+
+    def search(query: str, k: int) -> List[int]:
+        q = corpus.embed_query(query)
+        q_scale = max(float(np.abs(q).max()), 1e-12) / 127.0
+        q8 = np.round(q / q_scale).astype(np.int32)
+        scores = (quantized.astype(np.int32) @ q8).astype(np.float32) * scales * q_scale
+        return list(top_k(scores, k))
+    return search
+
+
+def build_ann(retriever: GodotDocsRetriever, corpus: Corpus, n_probe: int = 4) -> Callable[[str, int], List[int]]:
+    matrix = corpus.matrix
+    n_lists = max(1, int(math.sqrt(matrix.shape[0])))
+    rng = np.random.default_rng(0)
+    centroids = matrix[rng.choice(matrix.shape[0], n_lists, replace=False)]
+    for _ in range(10):
+        assignment = np.argmax(matrix @ centroids.T, axis=1)
+        for c in range(n_lists):
+            members = matrix[assignment == c]
+            if len(members):
+                centroid = members.mean(axis=0)
+                centroids[c] = centroid / max(float(np.linalg.norm(centroid)), 1e-12)
+    assignment = np.argmax(matrix @ centroids.T, axis=1)
+    lists = [np.nonzero(assignment == c)[0] for c in range(n_lists)]
+
+    def search(query: str, k: int) -> List[int]:
+        q = corpus.embed_query(query)
+        probes = top_k(centroids @ q, min(n_probe, n_lists))
+        candidates = np.concatenate([lists[c] for c in probes])
+        if candidates.size == 0:
+            return []
+        scores = matrix[candidates] @ q
+        return [int(candidates[i]) for i in top_k(scores, k)]
+    return search
+
+
+def build_hybrid(retriever: GodotDocsRetriever, corpus: Corpus, rrf_k: int = 60) -> Callable[[str, int], List[int]]:
+    dense = build_bruteforce(retriever, corpus)
+    doc_tokens = [Counter(tokenize(d)) for d in corpus.documents]
+    doc_lengths = [sum(t.values()) for t in doc_tokens]
+    avg_length = sum(doc_lengths) / max(1, len(doc_lengths))
+    document_frequency: Counter = Counter()
+    for tokens in doc_tokens:
+        document_frequency.update(tokens.keys())
+    n_docs = len(doc_tokens)
+
+    def bm25(query: str, k1: float = 1.2, b: float = 0.75) -> np.ndarray:
+        scores = np.zeros(n_docs, dtype=np.float32)
+        for term in set(tokenize(query)):
+            df = document_frequency.get(term)
+            if not df:
+                continue
+            idf = math.log(1.0 + (n_docs - df + 0.5) / (df + 0.5))
+            for i, tokens in enumerate(doc_tokens):
+                tf = tokens.get(term)
+                if tf:
+                    scores[i] += idf * tf * (k1 + 1) / (tf + k1 * (1 - b + b * doc_lengths[i] / avg_length))
+        return scores
+
+    def search(query: str, k: int) -> List[int]:
+        depth = max(k * 4, 20)
+        fused: Dict[int, float] = {}
+        for rank, i in enumerate(dense(query, depth)):
+            fused[int(i)] = fused.get(int(i), 0.0) + 1.0 / (rrf_k + rank + 1)
+        for rank, i in enumerate(top_k(bm25(query), depth)):
+            fused[int(i)] = fused.get(int(i), 0.0) + 1.0 / (rrf_k + rank + 1)
+        return [i for i, _ in sorted(fused.items(), key=lambda item: -item[1])[:k]]
+    return search
+
+
+BACKENDS = {
+    "chroma": build_chroma,
+    "bruteforce": build_bruteforce,
+    "batch": build_batch,
+    "quantized": build_quantized,
+    "ann": build_ann,
+    "hybrid": build_hybrid,
+}
+
+
+def is_relevant(section: str, expected: List[str]) -> bool:
+    # The whole section title has to match; a chunk merely mentioning the topic does not count.
+    return section.strip().lower() in (title.strip().lower() for title in expected)
+
+
+def evaluate(search: Callable[[str, int], List[int]], queries: List[Dict], corpus: Corpus, k: int, warmup: int) -> Dict:
+    for item in queries[:warmup]:
+        search(item["query"], k)
+
+    latencies = []
+    hits = 0
+    reciprocal_ranks = []
+    for item in queries:
+        start = time.perf_counter()
+        results = search(item["query"], k)
+        latencies.append((time.perf_counter() - start) * 1000.0)
+
+        rank = next((rank + 1 for rank, i in enumerate(results)
+                     if i >= 0 and is_relevant(corpus.sections[i], item["expected_sections"])), None)
+        hits += 1 if rank else 0
+        reciprocal_ranks.append(1.0 / rank if rank else 0.0)
+
+    return {
+        "recall_at_k": hits / max(1, len(queries)),
+        "mrr": sum(reciprocal_ranks) / max(1, len(queries)),
+        "latency_p50_ms": percentile(latencies, 50),
+        "latency_p99_ms": percentile(latencies, 99),
+    }
+
+
+def compare(result: Dict, baseline: Dict, max_recall_drop: float, max_latency_ratio: float) -> List[str]:
+    regressions = []
+    for name, current in result["backends"].items():
+        previous = baseline.get("backends", {}).get(name)
+        if not previous:
+            continue
+        for metric in ("recall_at_k", "mrr"):
+            if current[metric] < previous[metric] - max_recall_drop:
+                regressions.append(f"{name}: {metric} {previous[metric]:.3f} -> {current[metric]:.3f}")
+        # The absolute floors keep timer noise on very fast backends from reading as a regression.
+        for metric, floor in (("latency_p50_ms", 1.0), ("latency_p99_ms", 1.0), ("load_seconds", 0.05)):
+            if current[metric] > previous[metric] * max_latency_ratio and current[metric] - previous[metric] > floor:
+                regressions.append(f"{name}: {metric} {previous[metric]:.2f} -> {current[metric]:.2f}")
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Benchmark Godot documentation retrieval.")
+    parser.add_argument("--queries", default=os.path.join(BENCH_DIR, "retrieval_queries.json"))
+    parser.add_argument("--persist-directory", default="./chroma_db")
+    parser.add_argument("--backends", default=",".join(BACKENDS), help="Comma separated backend names")
+    parser.add_argument("--k", type=int, default=5)
+    parser.add_argument("--warmup", type=int, default=3)
+    parser.add_argument("--output", help="Write the JSON result here as well as to stdout")
+    parser.add_argument("--baseline", help="Earlier result to compare against")
+    parser.add_argument("--max-recall-drop", type=float, default=0.02)
+    parser.add_argument("--max-latency-ratio", type=float, default=1.25)
+    args = parser.parse_args()
+
+    with open(args.queries) as f:
+        queries = json.load(f)["queries"]
+
+    rss_start = rss_mb()
+    start = time.perf_counter()
+    # Without the warm-start snapshot, so "chroma" keeps measuring the store itself.
+    retriever = GodotDocsRetriever(persist_directory=args.persist_directory, snapshot_directory="")
+    corpus = Corpus(retriever)
+    base_load_seconds = time.perf_counter() - start
+    if not any(corpus.sections):
+        sys.exit("The store has no section metadata; rebuild it with create_embeddings.py.")
+    base_rss = rss_mb()
+
+    result = {
+        "k": args.k,
+        "queries": len(queries),
+        "chunks": len(corpus.documents),
+        "model_and_store_load_seconds": base_load_seconds,
+        "model_and_store_memory_mb": base_rss - rss_start,
+        "backends": {},
+    }
+
+    for name in args.backends.split(","):
+        name = name.strip()
+        if name not in BACKENDS:
+            parser.error(f"unknown backend: {name}")
+        rss_before = rss_mb()
+        start = time.perf_counter()
+        search = BACKENDS[name](retriever, corpus)
+        load_seconds = time.perf_counter() - start
+        metrics = evaluate(search, queries, corpus, args.k, args.warmup)
+        metrics["load_seconds"] = load_seconds
+        metrics["index_memory_mb"] = rss_mb() - rss_before
+        result["backends"][name] = metrics
+
+    text = json.dumps(result, indent=2)
+    print(text)
+    if args.output:
+        with open(args.output, "w") as f:
+            f.write(text + "\n")
+
+    if args.baseline:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+        regressions = compare(result, baseline, args.max_recall_drop, args.max_latency_ratio)
+        for regression in regressions:
+            print("REGRESSION " + regression, file=sys.stderr)
+        if regressions:
+            sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
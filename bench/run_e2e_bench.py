@@ -0,0 +1,110 @@
+"""
+End-to-end assistant benchmark: a headless editor binary talking to the mock completion server.
+
+Starts bench/mock_llm_server.py on a free port, points the AI backend at it via GODOT_AI_ENDPOINT,
+runs bench/e2e_bench.gd for the requested number of turns and prints one JSON document combining
+the turn timings, frame stalls and trace summary reported by the engine with the request and byte
+counters reported by the server.
+
+Usage:
+    python bench/run_e2e_bench.py --godot bin/godot.linuxbsd.editor.x86_64 --turns 20
+    python bench/run_e2e_bench.py --godot ... --rate-429 0.1 --output e2e.json
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import urllib.request
+from typing import Tuple
+
+BENCH_DIR = os.path.dirname(os.path.abspath(__file__))
+REPO_DIR = os.path.dirname(BENCH_DIR)
+
+
+def start_mock_server(args) -> Tuple[subprocess.Popen, int]:
+    command = [
+        sys.executable, os.path.join(BENCH_DIR, "mock_llm_server.py"),
+        "--port", "0",
+        "--latency-ms", str(args.latency_ms),
+        "--tokens-per-sec", str(args.tokens_per_sec),
+        "--reply-tokens", str(args.reply_tokens),
+        "--rate-429", str(args.rate_429),
+        "--drop-rate", str(args.drop_rate),
+        "--plan-files", str(args.plan_files),
+        "--seed", str(args.seed),
+    ]
+    server = subprocess.Popen(command, stdout=subprocess.PIPE, text=True)
+    line = server.stdout.readline()
+    if not line.startswith("MOCK_LLM_LISTENING"):
+        server.kill()
+        raise RuntimeError("Mock server did not start: " + line)
+    return server, int(line.split()[1])
+
+
+def fetch_stats(port: int) -> dict:
+    with urllib.request.urlopen(f"http://127.0.0.1:{port}/stats", timeout=5) as response:
+        return json.loads(response.read().decode("utf-8"))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Run the headless end-to-end assistant benchmark.")
+    parser.add_argument("--godot", required=True, help="Path to an editor build of the engine")
+    parser.add_argument("--project", default=REPO_DIR, help="Project directory passed with --path")
+    parser.add_argument("--turns", type=int, default=20)
+    parser.add_argument("--turn-timeout-msec", type=int, default=30000)
+    parser.add_argument("--latency-ms", type=float, default=200.0)
+    parser.add_argument("--tokens-per-sec", type=float, default=80.0)
+    parser.add_argument("--reply-tokens", type=int, default=120)
+    parser.add_argument("--rate-429", type=float, default=0.0)
+    parser.add_argument("--drop-rate", type=float, default=0.0)
+    parser.add_argument("--dock", choices=["chat", "composer"], default="chat",
+                        help="composer runs multi-file tasks, each planned into --plan-files parallel requests")
+    parser.add_argument("--plan-files", type=int, default=4)
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--output", help="Write the JSON result here as well as to stdout")
+    args = parser.parse_args()
+
+    server, port = start_mock_server(args)
+    try:
+        env = dict(os.environ)
+        env["GODOT_AI_ENDPOINT"] = f"http://127.0.0.1:{port}/v1/chat/completions"
+        env["OPENAI_API_KEY"] = "mock"
+
+        timeout = args.turns * args.turn_timeout_msec / 1000.0 + 60.0
+        process = subprocess.run(
+            [args.godot, "--headless", "--path", args.project, "--script", os.path.join(BENCH_DIR, "e2e_bench.gd"),
+             "--", f"--turns={args.turns}", f"--turn-timeout-msec={args.turn_timeout_msec}", f"--dock={args.dock}"],
+            env=env, capture_output=True, text=True, timeout=timeout)
+
+        engine_result = None
+        for line in process.stdout.splitlines():
+            if line.startswith("E2E_RESULT "):
+                engine_result = json.loads(line[len("E2E_RESULT "):])
+        if engine_result is None:
+            sys.stderr.write(process.stdout + process.stderr)
+            raise RuntimeError(f"Engine exited with {process.returncode} without reporting a result")
+
+        server_stats = fetch_stats(port)
+    finally:
+        server.terminate()
+        server.wait()
+
+    completed = max(1, engine_result["completed"])
+    result = {
+        "engine": engine_result,
+        "server": server_stats,
+        "requests_per_turn": server_stats["requests"] / completed,
+        "request_bytes_per_turn": server_stats["bytes_received"] / completed,
+    }
+
+    text = json.dumps(result, indent=2)
+    print(text)
+    if args.output:
+        with open(args.output, "w") as f:
+            f.write(text + "\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,102 @@
+"""
+Warm-start benchmark for the documentation retriever.
+
+The editor runs every search in a fresh Python process, so each one starts cold unless the
+warm-start snapshot lets it skip loading the store and the embedding model. This runs the labelled
+queries twice, one process per search, as the editor does: once with the snapshot disabled and
+once with it enabled. It reports the wall time of the first search and of the later ones as JSON.
+The snapshot run repeats the query list, so its second pass shows searches whose query embeddings
+were cached by an earlier process.
+
+Usage:
+    python bench/warm_start_bench.py --searches 10 --output warm_start.json
+"""
+
+import argparse
+import json
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+from typing import Dict, List
+
+BENCH_DIR = os.path.dirname(os.path.abspath(__file__))
+REPO_DIR = os.path.dirname(BENCH_DIR)
+
+SEARCH_SCRIPT = """
+import sys
+from godot_docs_retriever import GodotDocsRetriever
+retriever = GodotDocsRetriever(persist_directory=sys.argv[1], snapshot_directory=sys.argv[2])
+retriever.search(sys.argv[3], 5)
+retriever.save_snapshot()
+"""
+
+WARM_START_SCRIPT = """
+import sys
+from godot_docs_retriever import GodotDocsRetriever
+GodotDocsRetriever(persist_directory=sys.argv[1], snapshot_directory=sys.argv[2]).warm_start()
+"""
+
+
+def run_script(script: str, *args: str) -> float:
+    env = dict(os.environ)
+    env["PYTHONPATH"] = REPO_DIR + os.pathsep + env.get("PYTHONPATH", "")
+    start = time.perf_counter()
+    subprocess.run([sys.executable, "-c", script, *args], env=env, check=True, capture_output=True)
+    return time.perf_counter() - start
+
+
+def run_search(persist_directory: str, snapshot_directory: str, query: str) -> float:
+    return run_script(SEARCH_SCRIPT, persist_directory, snapshot_directory, query)
+
+
+def summarize(seconds: List[float]) -> Dict:
+    later = seconds[1:] or seconds
+    return {
+        "first_search_seconds": seconds[0],
+        "later_search_seconds_mean": sum(later) / len(later),
+        "search_seconds": seconds,
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare cold and warm-start retriever processes.")
+    parser.add_argument("--queries", default=os.path.join(BENCH_DIR, "retrieval_queries.json"))
+    parser.add_argument("--persist-directory", default="./chroma_db")
+    parser.add_argument("--searches", type=int, default=10, help="Searches per run")
+    parser.add_argument("--output", help="Write the JSON result here as well as to stdout")
+    args = parser.parse_args()
+
+    with open(args.queries) as f:
+        queries = [entry["query"] for entry in json.load(f)["queries"]]
+    distinct = queries[:max(1, args.searches // 2)]
+    sequence = (distinct * 2)[:args.searches]
+
+    cold = [run_search(args.persist_directory, "", query) for query in sequence]
+
+    snapshot_directory = tempfile.mkdtemp(prefix="godot_ai_warm_start_")
+    try:
+        # The first process builds the snapshot, as initialize() does in the editor. Searches
+        # never build it themselves.
+        build_seconds = run_script(WARM_START_SCRIPT, args.persist_directory, snapshot_directory)
+        warm = [run_search(args.persist_directory, snapshot_directory, query) for query in sequence]
+    finally:
+        shutil.rmtree(snapshot_directory, ignore_errors=True)
+
+    result = {
+        "searches": len(sequence),
+        "snapshot_build_seconds": build_seconds,
+        "cold": summarize(cold),
+        "warm": summarize(warm),
+    }
+    text = json.dumps(result, indent=2)
+    print(text)
+    if args.output:
+        with open(args.output, "w") as f:
+            f.write(text + "\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -3,6 +3,38 @@ from langchain_community.document_loaders import TextLoader
 from langchain_community.vectorstores import Chroma
 from langchain_community.embeddings import HuggingFaceEmbeddings
 
+import bisect
+import re
+
+# A reStructuredText title underline: one punctuation character repeated.
+UNDERLINE = re.compile(r"^([=\-~^*+#\"'`])\1{2,}$")
+
+def find_sections(text):
+    """
+    Offsets and titles of the headings in the documentation text, in order.
+
+    Both reStructuredText titles (a line underlined with punctuation) and Markdown headings
+    outside code fences are recognized.
+    """
+    offsets = []
+    titles = []
+    lines = text.splitlines(keepends=True)
+    offset = 0
+    in_fence = False
+    for i, line in enumerate(lines):
+        stripped = line.strip()
+        if stripped.startswith("```"):
+            in_fence = not in_fence
+        elif not in_fence and re.match(r"^#{1,6} ", stripped):
+            offsets.append(offset)
+            titles.append(stripped.lstrip("#").strip())
+        elif (stripped and not UNDERLINE.match(stripped) and i + 1 < len(lines)
+                and UNDERLINE.match(lines[i + 1].strip()) and len(lines[i + 1].strip()) >= len(stripped)):
+            offsets.append(offset)
+            titles.append(stripped)
+        offset += len(line)
+    return offsets, titles
+
 def create_vectorstore():
     # Initialize embeddings
     embeddings = HuggingFaceEmbeddings(model_name="all-MiniLM-L6-v2")
@@ -17,10 +49,22 @@ def create_vectorstore():
         chunk_overlap=200,
         length_function=len,
         is_separator_regex=False,
+        add_start_index=True,
     )
     
     # Split the documents
     splits = text_splitter.split_documents(documents)
+
+    # Every chunk is tagged with the section its middle falls in, which identifies it across
+    # rebuilds (the retrieval benchmark labels its queries with these).
+    for document in documents:
+        offsets, titles = find_sections(document.page_content)
+        for split in splits:
+            if split.metadata.get("source") != document.metadata.get("source"):
+                continue
+            middle = split.metadata["start_index"] + len(split.page_content) // 2
+            index = bisect.bisect_right(offsets, middle) - 1
+            split.metadata["section"] = titles[index] if index >= 0 else ""
     
     # Create and persist the vectorstore
     vectorstore = Chroma.from_documents(
@@ -1,26 +1,83 @@
 #include "ai_backend.h"
 
 #include "core/config/project_settings.h"
+#include "core/crypto/crypto_core.h"
+#include "core/io/compression.h"
 #include "core/io/json.h"
 #include "editor/editor_node.h"
 #include "editor/editor_settings.h"
 #include "core/string/translation.h"
+#include "core/math/math_funcs.h"
+#include "core/os/os.h"
+#include "scene/main/scene_tree.h"
+#include "ai_trace.h"
+
+// Backoff used when the server does not send Retry-After.
+static const double RETRY_BASE_DELAY_SEC = 1.0;
+static const double RETRY_MAX_DELAY_SEC = 30.0;
+
+// Below this, gzip framing costs more than it saves.
+static const int COMPRESS_MIN_BYTES = 1024;
+
+static const char *CHAT_SYSTEM_PROMPT = "You are a helpful AI assistant integrated into the Godot game engine editor. You help users with game development, coding, and engine-related questions.";
+static const char *RELEVANCE_SYSTEM_PROMPT = "You are a classifier that determines if a message is relevant to the Godot game engine and game development. Respond with 'true' for relevant messages and 'false' for irrelevant ones. A message is relevant if it's about:\n1. Godot engine features, APIs, or functionality\n2. Game development concepts or techniques\n3. Game design or implementation using Godot\n4. Technical questions about game development\n5. Game asset creation or management in Godot\n6. Game programming concepts\n7. Game optimization or performance\n8. Game testing and debugging\n9. Game deployment and publishing\n10. Game development workflows\nRespond only with 'true' or 'false'.";
 
 AIBackend *AIBackend::singleton = nullptr;
+HashMap<String, AIBackend::RateLimits> AIBackend::rate_limits;
+HashMap<String, Vector<Callable>> AIBackend::inflight_requests;
+
+void AIBackend::TokenBucket::refill(uint64_t p_now_usec) {
+    if (last_refill_usec != 0 && p_now_usec > last_refill_usec) {
+        available = MIN(capacity, available + refill_per_sec * (p_now_usec - last_refill_usec) / 1000000.0);
+    }
+    last_refill_usec = p_now_usec;
+}
+
+void AIBackend::TokenBucket::consume(double p_amount) {
+    if (capacity > 0.0) {
+        available -= p_amount;
+    }
+}
+
+void AIBackend::TokenBucket::update(double p_limit, double p_remaining, double p_reset_sec, uint64_t p_now_usec) {
+    capacity = p_limit;
+    available = MIN(p_remaining, p_limit);
+    // The reset header tells how long until the bucket is full again, which gives the refill rate.
+    refill_per_sec = p_reset_sec > 0.0 ? (p_limit - available) / p_reset_sec : p_limit;
+    last_refill_usec = p_now_usec;
+}
+
+double AIBackend::TokenBucket::get_delay(double p_amount) const {
+    if (capacity <= 0.0) {
+        return 0.0;
+    }
+    // Requests larger than the whole bucket can never fit, so only wait for a full bucket.
+    double needed = MIN(p_amount, capacity) - available;
+    if (needed <= 0.0) {
+        return 0.0;
+    }
+    return refill_per_sec > 0.0 ? needed / refill_per_sec : RETRY_BASE_DELAY_SEC;
+}
 
 void AIBackend::_bind_methods() {
-    ClassDB::bind_method(D_METHOD("send_message", "message", "callback"), &AIBackend::send_message);
+    ClassDB::bind_method(D_METHOD("send_message", "message", "callback", "context", "history_context"), &AIBackend::send_message, DEFVAL(PackedStringArray()), DEFVAL(PackedStringArray()));
     ClassDB::bind_method(D_METHOD("clear_history"), &AIBackend::clear_history);
     ClassDB::bind_method(D_METHOD("_http_request_completed"), &AIBackend::_http_request_completed);
     ClassDB::bind_method(D_METHOD("_relevance_request_completed"), &AIBackend::_relevance_request_completed);
     ClassDB::bind_method(D_METHOD("check_godot_relevance", "message", "callback"), &AIBackend::check_godot_relevance);
+    ClassDB::bind_method(D_METHOD("request_completion", "system_prompt", "message", "callback"), &AIBackend::request_completion);
+    ClassDB::bind_method(D_METHOD("get_max_parallel_requests"), &AIBackend::get_max_parallel_requests);
+    ClassDB::bind_method(D_METHOD("set_chat_provider", "provider"), &AIBackend::set_chat_provider);
+    ClassDB::bind_method(D_METHOD("get_chat_provider"), &AIBackend::get_chat_provider);
+    ClassDB::bind_method(D_METHOD("set_fast_provider", "provider"), &AIBackend::set_fast_provider);
+    ClassDB::bind_method(D_METHOD("get_fast_provider"), &AIBackend::get_fast_provider);
 }
 
 Error AIBackend::initialize() {
     _load_settings();
     
-    if (api_key.is_empty()) {
-        EditorNode::get_singleton()->show_warning("OpenAI API key not found. Please set it in Editor Settings under Interface > AI.");
+    if (!chat_provider->is_configured()) {
+        _show_warning(_get_unconfigured_message(chat_provider));
         return ERR_UNCONFIGURED;
     }
     
@@ -30,217 +87,739 @@ Error AIBackend::initialize() {
     relevance_request = memnew(HTTPRequest);
     relevance_request->set_use_threads(true);
     
-    // Use call_deferred to add the child nodes when the tree is ready
-    EditorNode::get_singleton()->call_deferred("add_child", request);
-    EditorNode::get_singleton()->call_deferred("add_child", relevance_request);
+    // Use call_deferred to add the child nodes when the tree is ready.
+    // Outside the editor (headless benchmarks) they go under the scene root instead.
+    Node *parent = EditorNode::get_singleton();
+    if (!parent) {
+        parent = SceneTree::get_singleton()->get_root();
+    }
+    parent->call_deferred("add_child", request);
+    parent->call_deferred("add_child", relevance_request);
     
-    request->connect("request_completed", callable_mp(this, &AIBackend::_http_request_completed));
-    relevance_request->connect("request_completed", callable_mp(this, &AIBackend::_relevance_request_completed));
+    request->connect("request_completed", _get_completed_callable(CHANNEL_CHAT));
+    relevance_request->connect("request_completed", _get_completed_callable(CHANNEL_RELEVANCE));
+
+    chat_pending.http = request;
+    relevance_pending.http = relevance_request;
+
+    // One HTTPRequest per slot, since each node carries a single request at a time.
+    pool_slots.resize(max_parallel_requests);
+    for (int i = 0; i < max_parallel_requests; i++) {
+        HTTPRequest *pool_request = memnew(HTTPRequest);
+        pool_request->set_use_threads(true);
+        parent->call_deferred("add_child", pool_request);
+        pool_request->connect("request_completed", _get_completed_callable(CHANNEL_POOL + i));
+        pool_slots[i].http = pool_request;
+    }
     
     return OK;
 }
 
 void AIBackend::_load_settings() {
-    api_key = OS::get_singleton()->get_environment("OPENAI_API_KEY");
-    print_line(vformat("Trying to load API key from environment: %s", api_key.is_empty() ? "Not found" : "Found"));
+    bool verbose = AITrace::is_verbose_logging();
+
+    String api_key = OS::get_singleton()->get_environment("OPENAI_API_KEY");
+    if (verbose) {
+        print_line(vformat("Trying to load API key from environment: %s", api_key.is_empty() ? "Not found" : "Found"));
+    }
     
     if (api_key.is_empty()) {
-        Variant api_key_setting = EditorSettings::get_singleton()->get_setting("interface/ai/openai_api_key");
-        print_line(vformat("Trying to load API key from editor settings: %s", api_key_setting.get_type() != Variant::NIL ? "Found" : "Not found"));
+        Variant api_key_setting = _get_setting("interface/ai/openai_api_key");
+        if (verbose) {
+            print_line(vformat("Trying to load API key from editor settings: %s", api_key_setting.get_type() != Variant::NIL ? "Found" : "Not found"));
+        }
         if (api_key_setting.get_type() != Variant::NIL) {
             api_key = api_key_setting;
         }
     }
     
-    Variant model_setting = EditorSettings::get_singleton()->get_setting("interface/ai/model");
-    model = model_setting.get_type() != Variant::NIL ? String(model_setting) : "gpt-3.5-turbo";
-    print_line(vformat("Using model: %s", model));
+    Variant model_setting = _get_setting("interface/ai/model");
+    String model = model_setting.get_type() != Variant::NIL ? String(model_setting) : "gpt-3.5-turbo";
+    if (verbose) {
+        print_line(vformat("Using model: %s", model));
+    }
     
-    Variant temp_setting = EditorSettings::get_singleton()->get_setting("interface/ai/temperature");
+    Variant temp_setting = _get_setting("interface/ai/temperature");
     temperature = temp_setting.get_type() != Variant::NIL ? float(temp_setting) : 0.7f;
     
-    Variant tokens_setting = EditorSettings::get_singleton()->get_setting("interface/ai/max_tokens");
+    Variant tokens_setting = _get_setting("interface/ai/max_tokens");
     max_tokens = tokens_setting.get_type() != Variant::NIL ? int(tokens_setting) : 1000;
+
+    Variant retries_setting = _get_setting("interface/ai/max_retries");
+    max_retries = retries_setting.get_type() != Variant::NIL ? int(retries_setting) : 4;
+
+    // The shared rate limits still apply, so a larger pool only helps while the server has headroom.
+    Variant parallel_setting = _get_setting("interface/ai/max_parallel_requests");
+    max_parallel_requests = CLAMP(parallel_setting.get_type() != Variant::NIL ? int(parallel_setting) : 4, 1, 16);
+
+    // The environment wins so benchmarks can point the editor at a local mock server.
+    String api_endpoint = OS::get_singleton()->get_environment("GODOT_AI_ENDPOINT");
+    if (api_endpoint.is_empty()) {
+        Variant endpoint_setting = _get_setting("interface/ai/api_endpoint");
+        api_endpoint = endpoint_setting.get_type() != Variant::NIL ? String(endpoint_setting) : "https://api.openai.com/v1/chat/completions";
+    }
+
+    // Providers set from script before initialize() are kept.
+    if (chat_provider.is_null()) {
+        Variant compress_setting = _get_setting("interface/ai/compress_requests");
+        chat_provider.instantiate();
+        chat_provider->set_endpoint(api_endpoint);
+        chat_provider->set_api_key(api_key);
+        chat_provider->set_model(model);
+        chat_provider->set_compress_requests(compress_setting.get_type() != Variant::NIL && bool(compress_setting));
+    }
+
+    if (fast_provider.is_null()) {
+        // A separate endpoint or model for cheap calls, e.g. a small model on a local llama.cpp server.
+        Variant fast_endpoint_setting = _get_setting("interface/ai/fast_endpoint");
+        Variant fast_model_setting = _get_setting("interface/ai/fast_model");
+        Variant fast_key_setting = _get_setting("interface/ai/fast_api_key");
+        String fast_endpoint = fast_endpoint_setting.get_type() != Variant::NIL ? String(fast_endpoint_setting) : String();
+        String fast_model = fast_model_setting.get_type() != Variant::NIL ? String(fast_model_setting) : String();
+
+        if (fast_endpoint.is_empty() && fast_model.is_empty()) {
+            fast_provider = chat_provider;
+        } else {
+            fast_provider.instantiate();
+            fast_provider->set_endpoint(fast_endpoint.is_empty() ? chat_provider->get_endpoint() : fast_endpoint);
+            fast_provider->set_model(fast_model.is_empty() ? chat_provider->get_model() : fast_model);
+            fast_provider->set_compress_requests(fast_endpoint.is_empty() && chat_provider->is_compressing_requests());
+            if (fast_key_setting.get_type() != Variant::NIL) {
+                fast_provider->set_api_key(fast_key_setting);
+            } else if (fast_endpoint.is_empty()) {
+                fast_provider->set_api_key(chat_provider->get_api_key());
+            }
+        }
+        if (verbose) {
+            print_line(vformat("Using fast model %s at %s", fast_provider->get_model(), fast_provider->get_endpoint()));
+        }
+    }
 }
 
-void AIBackend::send_message(const String &p_message, const Callable &p_callback) {
-    if (!request || !request->is_inside_tree()) {
-        ERR_FAIL_MSG("AI Backend not properly initialized or still initializing. Please try again in a moment.");
+Variant AIBackend::_get_setting(const String &p_name) {
+    if (!EditorSettings::get_singleton()) {
+        return Variant();
+    }
+    return EditorSettings::get_singleton()->get_setting(p_name);
+}
+
+void AIBackend::_show_warning(const String &p_message) {
+    if (EditorNode::get_singleton()) {
+        EditorNode::get_singleton()->show_warning(p_message);
+    } else {
+        WARN_PRINT(p_message);
+    }
+}
+
+String AIBackend::_get_unconfigured_message(const Ref<AIProvider> &p_provider) {
+    if (p_provider->get_endpoint().is_empty()) {
+        return "No AI API endpoint is set. Please set it in Editor Settings under Interface > AI.";
+    }
+    return vformat("No API key is set for %s. Please set it in Editor Settings under Interface > AI.", p_provider->get_endpoint());
+}
+
+AIBackend::PendingRequest &AIBackend::_get_pending(int p_channel) {
+    if (p_channel >= CHANNEL_POOL) {
+        return pool_slots[p_channel - CHANNEL_POOL];
+    }
+    return p_channel == CHANNEL_RELEVANCE ? relevance_pending : chat_pending;
+}
+
+Ref<AIProvider> AIBackend::_get_provider(int p_channel) const {
+    return p_channel == CHANNEL_RELEVANCE ? fast_provider : chat_provider;
+}
+
+AIBackend::RateLimits &AIBackend::_get_rate_limits(int p_channel) {
+    Ref<AIProvider> provider = _get_provider(p_channel);
+    return rate_limits[provider.is_valid() ? provider->get_endpoint() : String()];
+}
+
+Callable AIBackend::_get_completed_callable(int p_channel) {
+    if (p_channel >= CHANNEL_POOL) {
+        return callable_mp(this, &AIBackend::_pool_request_completed).bind(p_channel - CHANNEL_POOL);
+    }
+    if (p_channel == CHANNEL_RELEVANCE) {
+        return callable_mp(this, &AIBackend::_relevance_request_completed);
+    }
+    return callable_mp(this, &AIBackend::_http_request_completed);
+}
+
+void AIBackend::_complete_request(int p_channel, int p_result, int p_code, const PackedStringArray &p_headers, const PackedByteArray &p_body) {
+    _get_completed_callable(p_channel).call(p_result, p_code, p_headers, p_body);
+}
+
+void AIBackend::_start_request(int p_channel, const PackedByteArray &p_body, int p_estimated_tokens, const Callable &p_callback) {
+    PendingRequest &pending = _get_pending(p_channel);
+    ERR_FAIL_COND_MSG(pending.busy, "AI request channel is still busy.");
+    pending.busy = true;
+    pending.callback = p_callback;
+    pending.body = p_body;
+    pending.compressed_body.clear();
+    pending.attempt = 0;
+    pending.estimated_tokens = p_estimated_tokens;
+
+    unsigned char hash[32];
+    CryptoCore::sha256(p_body.ptr(), p_body.size(), hash);
+    String key = String::hex_encode_buffer(hash, 32);
+
+    // An identical request is already on the wire (e.g. the same relevance check from another dock).
+    // Wait for its response instead of paying for a second one.
+    Vector<Callable> *waiters = inflight_requests.getptr(key);
+    AITrace::record_cache(AITrace::CACHE_REQUEST_COALESCING, waiters != nullptr);
+    if (waiters) {
+        pending.coalesce_key = String();
+        pending.coalesced = true;
+        waiters->push_back(_get_completed_callable(p_channel));
         return;
     }
 
-    if (api_key.is_empty()) {
-        EditorNode::get_singleton()->show_warning("OpenAI API key not found. Please set it in Editor Settings under Interface > AI.");
+    pending.coalesce_key = key;
+    pending.coalesced = false;
+    inflight_requests.insert(key, Vector<Callable>());
+    _dispatch_request(p_channel);
+}
+
+void AIBackend::_dispatch_request(int p_channel) {
+    PendingRequest &pending = _get_pending(p_channel);
+    Ref<AIProvider> provider = _get_provider(p_channel);
+
+    if (provider.is_valid() && provider->has_in_process_completion()) {
+        // Local inference has no rate limits; it only must not block the editor.
+        pending.sent_usec = AITrace::now();
+        pending.task_id = WorkerThreadPool::get_singleton()->add_task(callable_mp(this, &AIBackend::_run_in_process).bind(p_channel, provider, pending.body), false, "AI in-process completion");
         return;
     }
 
-    print_line("Sending message to OpenAI API...");
-    print_line(vformat("API Key length: %d", api_key.length()));
-    print_line(vformat("Message length: %d", p_message.length()));
+    RateLimits &limits = _get_rate_limits(p_channel);
+    uint64_t now = OS::get_singleton()->get_ticks_usec();
+    limits.requests.refill(now);
+    limits.tokens.refill(now);
 
-    message_history.push_back(p_message);
-    response_callback = p_callback;
-    
-    Dictionary messages;
-    Array message_array;
-    
-    // Add system message
-    Dictionary system_message;
-    system_message["role"] = "system";
-    system_message["content"] = "You are a helpful AI assistant integrated into the Godot game engine editor. You help users with game development, coding, and engine-related questions.";
-    message_array.push_back(system_message);
-    
-    // Add message history
-    for (const String &msg : message_history) {
-        Dictionary user_message;
-        user_message["role"] = "user";
-        user_message["content"] = msg;
-        message_array.push_back(user_message);
+    // Hold the request back rather than sending it into a 429.
+    double delay = MAX(limits.requests.get_delay(1.0), limits.tokens.get_delay(pending.estimated_tokens));
+    if (limits.blocked_until_usec > now) {
+        delay = MAX(delay, (limits.blocked_until_usec - now) / 1000000.0);
     }
-    
-    Dictionary data;
-    data["model"] = model;
-    data["messages"] = message_array;
-    data["temperature"] = temperature;
-    data["max_tokens"] = max_tokens;
-    
-    String json = JSON::stringify(data);
-    print_line(vformat("Request JSON length: %d", json.length()));
-    
-    Error err = request->request(
-        "https://api.openai.com/v1/chat/completions",
-        Vector<String>({ 
-            "Content-Type: application/json",
-            "Authorization: Bearer " + api_key
-        }),
-        HTTPClient::METHOD_POST,
-        json
-    );
-    
+    if (delay > 0.0) {
+        SceneTree::get_singleton()->create_timer(delay)->connect("timeout", callable_mp(this, &AIBackend::_dispatch_request).bind(p_channel), CONNECT_ONE_SHOT);
+        return;
+    }
+
+    limits.requests.consume(1.0);
+    limits.tokens.consume(pending.estimated_tokens);
+
+    pending.sent_usec = AITrace::now();
+    Error err = ERR_UNCONFIGURED;
+    if (pending.http && pending.http->is_inside_tree() && provider.is_valid()) {
+        if (provider->is_compressing_requests() && pending.body.size() >= COMPRESS_MIN_BYTES) {
+            // Compressed once per request; retries resend the same bytes.
+            if (pending.compressed_body.is_empty()) {
+                pending.compressed_body.resize(Compression::get_max_compressed_buffer_size(pending.body.size(), Compression::MODE_GZIP));
+                int size = Compression::compress(pending.compressed_body.ptrw(), pending.body.ptr(), pending.body.size(), Compression::MODE_GZIP);
+                pending.compressed_body.resize(MAX(size, 0));
+            }
+        }
+        if (!pending.compressed_body.is_empty()) {
+            Vector<String> headers = provider->get_headers();
+            headers.push_back("Content-Encoding: gzip");
+            err = pending.http->request_raw(provider->get_endpoint(), headers, HTTPClient::METHOD_POST, pending.compressed_body);
+        } else {
+            // The body is already UTF-8, so it goes out as is instead of through a String.
+            err = pending.http->request_raw(provider->get_endpoint(), provider->get_headers(), HTTPClient::METHOD_POST, pending.body);
+        }
+    }
+
     if (err != OK) {
-        String error_msg = vformat("Failed to send request to OpenAI API. Error code: %d", err);
-        EditorNode::get_singleton()->show_warning(error_msg);
+        ERR_PRINT(vformat("Failed to send request to the AI provider. Error code: %d", err));
+        // A busy node would answer with another request's response, so that is not retried.
+        int result = err == ERR_BUSY ? HTTPRequest::RESULT_REQUEST_FAILED : HTTPRequest::RESULT_CANT_CONNECT;
+        _complete_request(p_channel, result, 0, PackedStringArray(), PackedByteArray());
+    }
+}
+
+void AIBackend::_run_in_process(int p_channel, const Ref<AIProvider> &p_provider, const PackedByteArray &p_body) {
+    String response = p_provider->complete(String::utf8((const char *)p_body.ptr(), p_body.size()));
+    callable_mp(this, &AIBackend::_in_process_completed).call_deferred(p_channel, response);
+}
+
+void AIBackend::_in_process_completed(int p_channel, const String &p_response) {
+    PendingRequest &pending = _get_pending(p_channel);
+    if (pending.task_id != WorkerThreadPool::INVALID_TASK_ID) {
+        WorkerThreadPool::get_singleton()->wait_for_task_completion(pending.task_id);
+        pending.task_id = WorkerThreadPool::INVALID_TASK_ID;
+    }
+    // Handled exactly like an HTTP response, so coalesced waiters and parsing stay the same.
+    int code = p_response.is_empty() ? 500 : 200;
+    _complete_request(p_channel, HTTPRequest::RESULT_SUCCESS, code, PackedStringArray(), p_response.to_utf8_buffer());
+}
+
+bool AIBackend::_retry_if_needed(int p_channel, int p_result, int p_code, const PackedStringArray &p_headers) {
+    PendingRequest &pending = _get_pending(p_channel);
+
+    bool retryable = false;
+    switch (p_result) {
+        case HTTPRequest::RESULT_SUCCESS:
+            retryable = p_code == 429 || p_code >= 500;
+            break;
+        case HTTPRequest::RESULT_CANT_CONNECT:
+        case HTTPRequest::RESULT_CANT_RESOLVE:
+        case HTTPRequest::RESULT_CONNECTION_ERROR:
+        case HTTPRequest::RESULT_NO_RESPONSE:
+        case HTTPRequest::RESULT_TIMEOUT:
+            retryable = true;
+            break;
+        default:
+            break;
+    }
+    if (!retryable || pending.attempt >= max_retries) {
+        return false;
+    }
+
+    double delay = -1.0;
+    String retry_after_ms = _get_header(p_headers, "retry-after-ms");
+    String retry_after = _get_header(p_headers, "retry-after");
+    if (retry_after_ms.is_valid_float()) {
+        delay = retry_after_ms.to_float() / 1000.0;
+    } else if (retry_after.is_valid_float()) {
+        delay = retry_after.to_float();
+    }
+
+    if (delay < 0.0) {
+        // Equal jitter: keep at least half the backoff so retries still spread out.
+        double backoff = MIN(RETRY_MAX_DELAY_SEC, RETRY_BASE_DELAY_SEC * Math::pow(2.0, pending.attempt));
+        delay = backoff * 0.5 + Math::random(0.0, backoff * 0.5);
+    }
+
+    if (p_code == 429) {
+        // The limit is shared by every channel using this endpoint, so stop the others from sending too.
+        RateLimits &limits = _get_rate_limits(p_channel);
+        uint64_t until = OS::get_singleton()->get_ticks_usec() + uint64_t(delay * 1000000.0);
+        limits.blocked_until_usec = MAX(limits.blocked_until_usec, until);
+    }
+
+    pending.attempt++;
+    if (AITrace::is_verbose_logging()) {
+        print_line(vformat("Request to %s failed (result %d, code %d), retrying in %.1f s (attempt %d of %d).", _get_provider(p_channel)->get_endpoint(), p_result, p_code, delay, pending.attempt, max_retries));
+    }
+    SceneTree::get_singleton()->create_timer(delay)->connect("timeout", callable_mp(this, &AIBackend::_dispatch_request).bind(p_channel), CONNECT_ONE_SHOT);
+    return true;
+}
+
+bool AIBackend::_settle_request(int p_channel, int p_result, int p_code, const PackedStringArray &p_headers, const PackedByteArray &p_body) {
+    PendingRequest &pending = _get_pending(p_channel);
+    if (pending.coalesced) {
+        // The response belongs to another request, which already handled retries.
+        pending.coalesced = false;
+        return true;
+    }
+
+    AITrace::record(AITrace::SPAN_NETWORK, pending.sent_usec, AITrace::now());
+    _update_rate_limits(p_channel, p_headers);
+    if (_retry_if_needed(p_channel, p_result, p_code, p_headers)) {
+        return false;
+    }
+
+    String key = pending.coalesce_key;
+    pending.coalesce_key = String();
+    _release_waiters(key, p_result, p_code, p_headers, p_body);
+    return true;
+}
+
+Callable AIBackend::_release_channel(int p_channel) {
+    PendingRequest &pending = _get_pending(p_channel);
+    Callable callback = pending.callback;
+    pending.callback = Callable();
+    pending.busy = false;
+    return callback;
+}
+
+void AIBackend::_release_waiters(const String &p_key, int p_result, int p_code, const PackedStringArray &p_headers, const PackedByteArray &p_body) {
+    if (p_key.is_empty() || !inflight_requests.has(p_key)) {
         return;
     }
-    
-    print_line("Request sent successfully");
+    Vector<Callable> waiters = inflight_requests[p_key];
+    inflight_requests.erase(p_key);
+
+    for (const Callable &waiter : waiters) {
+        if (waiter.is_valid()) {
+            waiter.call(p_result, p_code, p_headers, p_body);
+        }
+    }
 }
 
-void AIBackend::_http_request_completed(int p_result, int p_code, const PackedStringArray &p_headers, const PackedByteArray &p_body) {
-    if (p_result != HTTPRequest::RESULT_SUCCESS) {
-        EditorNode::get_singleton()->show_warning("Failed to connect to OpenAI API.");
+void AIBackend::_drop_inflight(PendingRequest &p_pending) {
+    if (p_pending.coalesced || p_pending.coalesce_key.is_empty() || !inflight_requests.has(p_pending.coalesce_key)) {
         return;
     }
-    
-    if (p_code != 200) {
-        String response_text;
-        response_text.parse_utf8((const char *)p_body.ptr(), p_body.size());
-        Dictionary response = JSON::parse_string(response_text);
-        
-        if (response.has("error")) {
-            Dictionary error = response["error"];
-            EditorNode::get_singleton()->show_warning(vformat("OpenAI API Error: %s", String(error["message"])));
+    // The response will never be handled, so requests waiting on it fail instead of hanging.
+    Vector<Callable> waiters = inflight_requests[p_pending.coalesce_key];
+    inflight_requests.erase(p_pending.coalesce_key);
+    p_pending.coalesce_key = String();
+    for (const Callable &waiter : waiters) {
+        if (waiter.is_valid() && waiter.get_object() != this) {
+            waiter.call_deferred(HTTPRequest::RESULT_CANT_CONNECT, 0, PackedStringArray(), PackedByteArray());
+        }
+    }
+}
+
+void AIBackend::_update_rate_limits(int p_channel, const PackedStringArray &p_headers) {
+    RateLimits &limits = _get_rate_limits(p_channel);
+    uint64_t now = OS::get_singleton()->get_ticks_usec();
+
+    String limit = _get_header(p_headers, "x-ratelimit-limit-requests");
+    String remaining = _get_header(p_headers, "x-ratelimit-remaining-requests");
+    if (limit.is_valid_int() && remaining.is_valid_int()) {
+        limits.requests.update(limit.to_int(), remaining.to_int(), _parse_reset_duration(_get_header(p_headers, "x-ratelimit-reset-requests")), now);
+    }
+
+    limit = _get_header(p_headers, "x-ratelimit-limit-tokens");
+    remaining = _get_header(p_headers, "x-ratelimit-remaining-tokens");
+    if (limit.is_valid_int() && remaining.is_valid_int()) {
+        limits.tokens.update(limit.to_int(), remaining.to_int(), _parse_reset_duration(_get_header(p_headers, "x-ratelimit-reset-tokens")), now);
+    }
+}
+
+String AIBackend::_get_header(const PackedStringArray &p_headers, const String &p_name) {
+    for (const String &header : p_headers) {
+        int separator = header.find_char(':');
+        if (separator != -1 && header.substr(0, separator).strip_edges().nocasecmp_to(p_name) == 0) {
+            return header.substr(separator + 1).strip_edges();
+        }
+    }
+    return String();
+}
+
+double AIBackend::_parse_reset_duration(const String &p_value) {
+    // Durations come in Go style, e.g. "1s", "6m0s", "20ms" or "1h2m3.5s".
+    double total = 0.0;
+    int i = 0;
+    while (i < p_value.length()) {
+        int start = i;
+        while (i < p_value.length() && (is_digit(p_value[i]) || p_value[i] == '.')) {
+            i++;
+        }
+        if (start == i) {
+            return 0.0;
+        }
+        double amount = p_value.substr(start, i - start).to_float();
+
+        int unit_start = i;
+        while (i < p_value.length() && is_ascii_alphabet_char(p_value[i])) {
+            i++;
+        }
+        String unit = p_value.substr(unit_start, i - unit_start);
+        if (unit == "h") {
+            total += amount * 3600.0;
+        } else if (unit == "m") {
+            total += amount * 60.0;
+        } else if (unit == "ms") {
+            total += amount / 1000.0;
         } else {
-            EditorNode::get_singleton()->show_warning(vformat("OpenAI API Error: %d", p_code));
+            total += amount;
         }
+    }
+    return total;
+}
+
+void AIBackend::_append_message_json(AIPayloadWriter &r_writer, const String &p_role, const String &p_content) {
+    r_writer.append("{\"role\":\"");
+    r_writer.append(p_role);
+    r_writer.append("\",\"content\":");
+    r_writer.append_json_string(p_content);
+    r_writer.append("}");
+}
+
+void AIBackend::_reset_serialized_prefix() {
+    serialized_prefix.clear();
+    serialized_count = 0;
+}
+
+void AIBackend::_update_serialized_prefix() {
+    if (serialized_prefix.is_empty()) {
+        // Request parameters first and the system prompt next, so nothing that varies per turn
+        // comes before the history.
+        serialized_prefix.append("{\"model\":");
+        serialized_prefix.append_json_string(chat_provider->get_model());
+        serialized_prefix.append(",\"temperature\":");
+        serialized_prefix.append_float(temperature);
+        serialized_prefix.append(",\"max_tokens\":");
+        serialized_prefix.append_int(max_tokens);
+        serialized_prefix.append(",\"messages\":[{\"role\":\"system\",\"content\":");
+        serialized_prefix.append_json_string(CHAT_SYSTEM_PROMPT);
+        serialized_prefix.append("}");
+        serialized_count = 0;
+    }
+
+    // Only messages added since the previous turn are serialized.
+    for (; serialized_count < message_history.size(); serialized_count++) {
+        const HistoryMessage &message = message_history[serialized_count];
+        serialized_prefix.append(",");
+        _append_message_json(serialized_prefix, message.role, message.content);
+    }
+}
+
+void AIBackend::send_message(const String &p_message, const Callable &p_callback, const PackedStringArray &p_context, const PackedStringArray &p_history_context) {
+    if (!request || !request->is_inside_tree()) {
+        ERR_PRINT("AI Backend not properly initialized or still initializing. Please try again in a moment.");
+        p_callback.call(String());
         return;
     }
-    
-    String response_text;
-    response_text.parse_utf8((const char *)p_body.ptr(), p_body.size());
-    Dictionary response = JSON::parse_string(response_text);
-    
-    Array choices = response.get("choices", Array());
-    if (choices.size() > 0) {
-        Dictionary choice = choices[0];
-        Dictionary message = choice.get("message", Dictionary());
-        String content = message.get("content", "");
-        message_history.push_back(content);
-        response_callback.call(content);
+
+    if (!chat_provider->is_configured()) {
+        _show_warning(_get_unconfigured_message(chat_provider));
+        p_callback.call(String());
+        return;
+    }
+
+    if (AITrace::is_verbose_logging()) {
+        print_line(vformat("Sending message to %s, message length: %d, context parts: %d", chat_provider->get_endpoint(), p_message.length(), p_history_context.size() + p_context.size()));
+    }
+
+    QueuedRequest turn;
+    turn.message = p_message;
+    turn.history_context = p_history_context;
+    turn.context = p_context;
+    turn.callback = p_callback;
+    chat_queue.push_back(turn);
+    _pump_requests();
+}
+
+void AIBackend::_write_chat_request(const String &p_message, const PackedStringArray &p_history_context, const PackedStringArray &p_context) {
+    _update_serialized_prefix();
+
+    // The per-turn context rides in the last message only, after the cached prefix. Everything is
+    // escaped straight into the reused body buffer.
+    request_writer.clear();
+    request_writer.append(serialized_prefix);
+    request_writer.append(",{\"role\":\"user\",\"content\":\"");
+    for (const String &part : p_history_context) {
+        request_writer.append_json_escaped(part);
+    }
+    for (const String &part : p_context) {
+        request_writer.append_json_escaped(part);
+    }
+    request_writer.append_json_escaped(p_message);
+    request_writer.append("\"}]}");
+    if (AITrace::is_verbose_logging()) {
+        print_line(vformat("Request JSON bytes: %d, reused prefix: %d", request_writer.size(), serialized_prefix.size()));
+    }
+}
+
+void AIBackend::_pump_requests() {
+    if (!chat_pending.busy && !chat_queue.is_empty()) {
+        QueuedRequest turn = chat_queue.front()->get();
+        chat_queue.pop_front();
+        // What the history keeps of this turn once it is answered.
+        pending_user_message = String().join(turn.history_context) + turn.message;
+        _write_chat_request(turn.message, turn.history_context, turn.context);
+        // Roughly four bytes per token, plus whatever the completion may use.
+        _start_request(CHANNEL_CHAT, request_writer.to_byte_array(), request_writer.size() / 4 + max_tokens, turn.callback);
+    }
+
+    if (!relevance_pending.busy && !relevance_queue.is_empty()) {
+        QueuedRequest check = relevance_queue.front()->get();
+        relevance_queue.pop_front();
+        _start_request(CHANNEL_RELEVANCE, check.body, check.estimated_tokens, check.callback);
+    }
+
+    for (uint32_t i = 0; i < pool_slots.size() && !completion_queue.is_empty(); i++) {
+        if (pool_slots[i].busy) {
+            continue;
+        }
+        QueuedRequest job = completion_queue.front()->get();
+        completion_queue.pop_front();
+        _start_request(CHANNEL_POOL + i, job.body, job.estimated_tokens, job.callback);
+    }
+}
+
+void AIBackend::_http_request_completed(int p_result, int p_code, const PackedStringArray &p_headers, const PackedByteArray &p_body) {
+    if (!_settle_request(CHANNEL_CHAT, p_result, p_code, p_headers, p_body)) {
+        return;
+    }
+
+    // Only the reply text is needed, so read it straight from the body instead of parsing
+    // the whole response into a Dictionary.
+    String content;
+    if (p_result != HTTPRequest::RESULT_SUCCESS) {
+        _show_warning(vformat("Failed to connect to %s.", chat_provider->get_endpoint()));
+    } else if (p_code != 200) {
+        String error_message;
+        if (json_reader.extract_string(p_body, "error.message", error_message)) {
+            _show_warning(vformat("AI API error from %s: %s", chat_provider->get_endpoint(), error_message));
+        } else {
+            _show_warning(vformat("AI API error from %s: HTTP %d", chat_provider->get_endpoint(), p_code));
+        }
+    } else if (json_reader.extract_string(p_body, "choices.0.message.content", content)) {
+        message_history.push_back({ "user", pending_user_message });
+        message_history.push_back({ "assistant", content });
+    } else {
+        // E.g. a content filter stop or a tool call, which carry no text.
+        String finish_reason;
+        json_reader.extract_string(p_body, "choices.0.finish_reason", finish_reason);
+        _show_warning(vformat("AI API error from %s: the response has no message content (finish reason: %s).", chat_provider->get_endpoint(), finish_reason.is_empty() ? String("unknown") : finish_reason));
+    }
+
+    // Every turn is answered, even when it failed, so callers waiting on it never stall.
+    Callable callback = _release_channel(CHANNEL_CHAT);
+    if (callback.is_valid()) {
+        callback.call(content);
     }
+    _pump_requests();
 }
 
 void AIBackend::clear_history() {
     message_history.clear();
+    _reset_serialized_prefix();
+}
+
+void AIBackend::set_chat_provider(const Ref<AIProvider> &p_provider) {
+    ERR_FAIL_COND_MSG(p_provider.is_null(), "The chat provider cannot be null.");
+    if (fast_provider == chat_provider) {
+        fast_provider = p_provider;
+    }
+    chat_provider = p_provider;
+    _reset_serialized_prefix();
+}
+
+Ref<AIProvider> AIBackend::get_chat_provider() const {
+    return chat_provider;
+}
+
+void AIBackend::set_fast_provider(const Ref<AIProvider> &p_provider) {
+    // Without a provider of their own, the cheap calls go to the chat provider.
+    fast_provider = p_provider.is_valid() ? p_provider : chat_provider;
+}
+
+Ref<AIProvider> AIBackend::get_fast_provider() const {
+    return fast_provider;
+}
+
+void AIBackend::restore_history(const Vector<HistoryMessage> &p_messages) {
+    message_history.clear();
+    for (const HistoryMessage &message : p_messages) {
+        message_history.push_back(message);
+    }
+    _reset_serialized_prefix();
 }
 
 void AIBackend::check_godot_relevance(const String &p_message, const Callable &p_callback) {
     if (!relevance_request || !relevance_request->is_inside_tree()) {
-        ERR_FAIL_MSG("AI Backend not properly initialized or still initializing.");
+        ERR_PRINT("AI Backend not properly initialized or still initializing.");
         p_callback.call(true); // Default to true if not initialized
         return;
     }
 
-    if (api_key.is_empty()) {
-        ERR_FAIL_MSG("OpenAI API key not found.");
+    if (!fast_provider->is_configured()) {
+        ERR_PRINT(_get_unconfigured_message(fast_provider));
         p_callback.call(true); // Default to true if no API key
         return;
     }
 
-    Dictionary data;
-    data["model"] = model;
-    
-    Array message_array;
-    
-    // Add system message
-    Dictionary system_message;
-    system_message["role"] = "system";
-    system_message["content"] = "You are a classifier that determines if a message is relevant to the Godot game engine and game development. Respond with 'true' for relevant messages and 'false' for irrelevant ones. A message is relevant if it's about:\n1. Godot engine features, APIs, or functionality\n2. Game development concepts or techniques\n3. Game design or implementation using Godot\n4. Technical questions about game development\n5. Game asset creation or management in Godot\n6. Game programming concepts\n7. Game optimization or performance\n8. Game testing and debugging\n9. Game deployment and publishing\n10. Game development workflows\nRespond only with 'true' or 'false'.";
-    message_array.push_back(system_message);
-    
-    // Add user message
-    Dictionary user_message;
-    user_message["role"] = "user";
-    user_message["content"] = p_message;
-    message_array.push_back(user_message);
-    
-    data["messages"] = message_array;
-    data["temperature"] = 0.0; // Use 0 temperature for more deterministic responses
-    data["max_tokens"] = 10; // We only need a short response
-    
-    String json = JSON::stringify(data);
-    
-    relevance_callback = p_callback;
-    pending_message = p_message;
-    
-    Error err = relevance_request->request(
-        "https://api.openai.com/v1/chat/completions",
-        Vector<String>({ 
-            "Content-Type: application/json",
-            "Authorization: Bearer " + api_key
-        }),
-        HTTPClient::METHOD_POST,
-        json
-    );
-    
-    if (err != OK) {
-        ERR_PRINT("Failed to send relevance check request to OpenAI API.");
-        p_callback.call(true); // Default to true on error
-    }
+    // Nothing here changes between calls except the message, so it is written without building
+    // a Dictionary first.
+    request_writer.clear();
+    request_writer.append("{\"model\":");
+    request_writer.append_json_string(fast_provider->get_model());
+    request_writer.append(",\"messages\":[{\"role\":\"system\",\"content\":");
+    request_writer.append_json_string(RELEVANCE_SYSTEM_PROMPT);
+    request_writer.append("},{\"role\":\"user\",\"content\":");
+    request_writer.append_json_string(p_message);
+    // 0 temperature for deterministic answers; only a one word reply is needed.
+    request_writer.append("}],\"temperature\":0,\"max_tokens\":10}");
+
+    QueuedRequest check;
+    check.body = request_writer.to_byte_array();
+    check.estimated_tokens = request_writer.size() / 4 + 10;
+    check.callback = p_callback;
+    relevance_queue.push_back(check);
+    _pump_requests();
 }
 
 void AIBackend::_relevance_request_completed(int p_result, int p_code, const PackedStringArray &p_headers, const PackedByteArray &p_body) {
+    if (!_settle_request(CHANNEL_RELEVANCE, p_result, p_code, p_headers, p_body)) {
+        return;
+    }
+
     bool is_relevant = true; // Default to true
     
     if (p_result == HTTPRequest::RESULT_SUCCESS && p_code == 200) {
-        String response_text;
-        response_text.parse_utf8((const char *)p_body.ptr(), p_body.size());
-        Dictionary response = JSON::parse_string(response_text);
-        
-        if (response.has("choices")) {
-            Array choices = response["choices"];
-            if (choices.size() > 0) {
-                Dictionary choice = choices[0];
-                Dictionary message = choice["message"];
-                String content = String(message["content"]).to_lower();
-                is_relevant = content.contains("true");
-            }
+        String content;
+        if (json_reader.extract_string(p_body, "choices.0.message.content", content)) {
+            is_relevant = content.to_lower().contains("true");
         }
     }
     
-    if (relevance_callback.is_valid()) {
-        relevance_callback.call(is_relevant);
+    Callable callback = _release_channel(CHANNEL_RELEVANCE);
+    if (callback.is_valid()) {
+        callback.call(is_relevant);
     }
+    _pump_requests();
+}
+
+void AIBackend::request_completion(const String &p_system_prompt, const String &p_message, const Callable &p_callback) {
+    if (!request || !request->is_inside_tree()) {
+        ERR_PRINT("AI Backend not properly initialized or still initializing. Please try again in a moment.");
+        p_callback.call(String());
+        return;
+    }
+
+    if (!chat_provider->is_configured()) {
+        _show_warning(_get_unconfigured_message(chat_provider));
+        p_callback.call(String());
+        return;
+    }
+
+    // Callers that fan out one task put the shared text first in the message, so the bodies of
+    // parallel requests share a prefix the server can cache.
+    request_writer.clear();
+    request_writer.append("{\"model\":");
+    request_writer.append_json_string(chat_provider->get_model());
+    request_writer.append(",\"temperature\":");
+    request_writer.append_float(temperature);
+    request_writer.append(",\"max_tokens\":");
+    request_writer.append_int(max_tokens);
+    request_writer.append(",\"messages\":[{\"role\":\"system\",\"content\":");
+    request_writer.append_json_string(p_system_prompt);
+    request_writer.append("},{\"role\":\"user\",\"content\":");
+    request_writer.append_json_string(p_message);
+    request_writer.append("}]}");
+
+    QueuedRequest job;
+    job.body = request_writer.to_byte_array();
+    job.estimated_tokens = request_writer.size() / 4 + max_tokens;
+    job.callback = p_callback;
+    completion_queue.push_back(job);
+    _pump_requests();
+}
+
+int AIBackend::get_max_parallel_requests() const {
+    return max_parallel_requests;
+}
+
+void AIBackend::_pool_request_completed(int p_result, int p_code, const PackedStringArray &p_headers, const PackedByteArray &p_body, int p_slot) {
+    int channel = CHANNEL_POOL + p_slot;
+    if (!_settle_request(channel, p_result, p_code, p_headers, p_body)) {
+        return;
+    }
+
+    // Several of these can fail at once, so errors are printed rather than shown as dialogs.
+    String content;
+    if (p_result != HTTPRequest::RESULT_SUCCESS) {
+        ERR_PRINT(vformat("AI completion failed to connect (result %d).", p_result));
+    } else if (p_code != 200) {
+        String error_message;
+        json_reader.extract_string(p_body, "error.message", error_message);
+        ERR_PRINT(vformat("AI completion failed with code %d: %s", p_code, error_message));
+    } else if (!json_reader.extract_string(p_body, "choices.0.message.content", content)) {
+        ERR_PRINT("AI completion response has no message content.");
+    }
+
+    // The slot is freed first so a callback that queues follow-up work can use it.
+    Callable callback = _release_channel(channel);
+    if (callback.is_valid()) {
+        callback.call(content);
+    }
+    _pump_requests();
 }
 
 AIBackend::AIBackend() {
@@ -248,6 +827,22 @@ AIBackend::AIBackend() {
 }
 
 AIBackend::~AIBackend() {
+    // In-process completions call back into this object.
+    if (chat_pending.task_id != WorkerThreadPool::INVALID_TASK_ID) {
+        WorkerThreadPool::get_singleton()->wait_for_task_completion(chat_pending.task_id);
+    }
+    if (relevance_pending.task_id != WorkerThreadPool::INVALID_TASK_ID) {
+        WorkerThreadPool::get_singleton()->wait_for_task_completion(relevance_pending.task_id);
+    }
+    _drop_inflight(chat_pending);
+    _drop_inflight(relevance_pending);
+    for (PendingRequest &slot : pool_slots) {
+        if (slot.task_id != WorkerThreadPool::INVALID_TASK_ID) {
+            WorkerThreadPool::get_singleton()->wait_for_task_completion(slot.task_id);
+        }
+        _drop_inflight(slot);
+        slot.http->queue_free();
+    }
     if (request) {
         request->queue_free();
     }
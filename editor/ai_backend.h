@@ -2,46 +2,178 @@
 #define AI_BACKEND_H
 
 #include "core/object/ref_counted.h"
+#include "core/object/worker_thread_pool.h"
+#include "core/templates/hash_map.h"
 #include "core/templates/list.h"
+#include "core/templates/local_vector.h"
 #include "core/variant/variant.h"
 #include "scene/main/http_request.h"
+#include "ai_json_reader.h"
+#include "ai_payload_writer.h"
+#include "ai_provider.h"
 
 class AIBackend : public RefCounted {
     GDCLASS(AIBackend, RefCounted);
 
+public:
+    struct HistoryMessage {
+        String role;
+        String content;
+    };
+
 private:
+    enum Channel {
+        CHANNEL_CHAT,
+        CHANNEL_RELEVANCE,
+        // Pool slot i uses channel CHANNEL_POOL + i.
+        CHANNEL_POOL,
+    };
+
+    // One request slot per HTTPRequest node. The body is kept so it can be resent on retry.
+    // A busy slot is never reused until its request has answered, including retries and waits.
+    struct PendingRequest {
+        HTTPRequest *http = nullptr;
+        PackedByteArray body;
+        PackedByteArray compressed_body;
+        // Key this request was registered under in inflight_requests; empty when coalesced.
+        String coalesce_key;
+        Callable callback;
+        int attempt = 0;
+        int estimated_tokens = 0;
+        uint64_t sent_usec = 0;
+        bool busy = false;
+        bool coalesced = false;
+        WorkerThreadPool::TaskID task_id = WorkerThreadPool::INVALID_TASK_ID;
+    };
+
+    // Client-side mirror of the server's rate limits, refilled linearly until the next response
+    // headers correct it. A capacity of 0 means the limit is unknown and nothing is throttled.
+    struct TokenBucket {
+        double capacity = 0.0;
+        double available = 0.0;
+        double refill_per_sec = 0.0;
+        uint64_t last_refill_usec = 0;
+
+        void refill(uint64_t p_now_usec);
+        void consume(double p_amount);
+        void update(double p_limit, double p_remaining, double p_reset_sec, uint64_t p_now_usec);
+        double get_delay(double p_amount) const;
+    };
+
+    struct RateLimits {
+        TokenBucket requests;
+        TokenBucket tokens;
+        uint64_t blocked_until_usec = 0;
+    };
+
+    // A request waiting for its channel to be free. Chat turns are serialized only when sent, so a
+    // turn queued behind another one carries that turn's reply in its history.
+    struct QueuedRequest {
+        PackedByteArray body;
+        int estimated_tokens = 0;
+        Callable callback;
+        String message;
+        PackedStringArray history_context;
+        PackedStringArray context;
+    };
+
     static AIBackend *singleton;
-    
-    String api_key;
-    String model;
+
+    // Shared by every backend instance, per endpoint, since docks talking to the same endpoint
+    // share its limits.
+    static HashMap<String, RateLimits> rate_limits;
+    static HashMap<String, Vector<Callable>> inflight_requests;
+
+    // Answers go to the chat provider. Cheap calls such as relevance checks go to the fast one,
+    // which is the chat provider unless a separate fast endpoint or model is configured.
+    Ref<AIProvider> chat_provider;
+    Ref<AIProvider> fast_provider;
     float temperature;
     int max_tokens;
-    
+    int max_retries;
+    int max_parallel_requests;
+
     HTTPRequest *request = nullptr;
     HTTPRequest *relevance_request = nullptr;
-    List<String> message_history;
-    Callable response_callback;
-    Callable relevance_callback;
-    String pending_message;
-    
-    void _send_request(const String &p_message);
+    PendingRequest chat_pending;
+    PendingRequest relevance_pending;
+    List<QueuedRequest> chat_queue;
+    List<QueuedRequest> relevance_queue;
+    // One-shot completions that do not touch the history, run concurrently up to the pool size.
+    // Sized once in initialize(), so slots never move while requests point at them.
+    LocalVector<PendingRequest> pool_slots;
+    List<QueuedRequest> completion_queue;
+    LocalVector<HistoryMessage> message_history;
+    // The question being answered; it joins the history once the reply arrives.
+    String pending_user_message;
+    // Request JSON up to the last history message, without the closing brackets. Turns only ever
+    // append to it, so the stable system and history prefix is serialized once and stays
+    // byte-identical between requests, which lets server-side prompt caching match it.
+    AIPayloadWriter serialized_prefix;
+    uint32_t serialized_count = 0;
+    // Reused for every request body so its buffer is only grown, never reallocated per turn.
+    AIPayloadWriter request_writer;
+    AIJsonReader json_reader;
+
+    PendingRequest &_get_pending(int p_channel);
+    Ref<AIProvider> _get_provider(int p_channel) const;
+    RateLimits &_get_rate_limits(int p_channel);
+    void _start_request(int p_channel, const PackedByteArray &p_body, int p_estimated_tokens, const Callable &p_callback);
+    void _dispatch_request(int p_channel);
+    bool _retry_if_needed(int p_channel, int p_result, int p_code, const PackedStringArray &p_headers);
+    bool _settle_request(int p_channel, int p_result, int p_code, const PackedStringArray &p_headers, const PackedByteArray &p_body);
+    Callable _release_channel(int p_channel);
+    void _release_waiters(const String &p_key, int p_result, int p_code, const PackedStringArray &p_headers, const PackedByteArray &p_body);
+    void _drop_inflight(PendingRequest &p_pending);
+    void _update_rate_limits(int p_channel, const PackedStringArray &p_headers);
+    void _run_in_process(int p_channel, const Ref<AIProvider> &p_provider, const PackedByteArray &p_body);
+    void _in_process_completed(int p_channel, const String &p_response);
+    void _complete_request(int p_channel, int p_result, int p_code, const PackedStringArray &p_headers, const PackedByteArray &p_body);
     void _http_request_completed(int p_result, int p_code, const PackedStringArray &p_headers, const PackedByteArray &p_body);
     void _relevance_request_completed(int p_result, int p_code, const PackedStringArray &p_headers, const PackedByteArray &p_body);
+    void _pool_request_completed(int p_result, int p_code, const PackedStringArray &p_headers, const PackedByteArray &p_body, int p_slot);
+    Callable _get_completed_callable(int p_channel);
+    void _pump_requests();
+    void _write_chat_request(const String &p_message, const PackedStringArray &p_history_context, const PackedStringArray &p_context);
     void _load_settings();
-    
+    void _reset_serialized_prefix();
+    void _update_serialized_prefix();
+
+    static Variant _get_setting(const String &p_name);
+    static void _show_warning(const String &p_message);
+    static String _get_unconfigured_message(const Ref<AIProvider> &p_provider);
+    static String _get_header(const PackedStringArray &p_headers, const String &p_name);
+    static double _parse_reset_duration(const String &p_value);
+    static void _append_message_json(AIPayloadWriter &r_writer, const String &p_role, const String &p_content);
+
 protected:
     static void _bind_methods();
-    
+
 public:
     static AIBackend *get_singleton() { return singleton; }
-    
+
     Error initialize();
-    void send_message(const String &p_message, const Callable &p_callback);
+    // The history context parts (e.g. editor state deltas, which later turns build on) are kept with
+    // the message in the history. The context parts (e.g. documentation) follow them and are only
+    // sent with this turn. Either way earlier turns never change once sent. Turns sent while another
+    // is in flight wait for it. The callback gets the reply, or an empty string if the request failed.
+    void send_message(const String &p_message, const Callable &p_callback, const PackedStringArray &p_context = PackedStringArray(), const PackedStringArray &p_history_context = PackedStringArray());
     void check_godot_relevance(const String &p_message, const Callable &p_callback);
+    // Sends a system prompt and one user message outside the conversation. Requests beyond
+    // max_parallel_requests wait for a free slot. The callback gets the reply, or an empty
+    // string if the request failed.
+    void request_completion(const String &p_system_prompt, const String &p_message, const Callable &p_callback);
+    int get_max_parallel_requests() const;
     void clear_history();
-    
+    void set_chat_provider(const Ref<AIProvider> &p_provider);
+    Ref<AIProvider> get_chat_provider() const;
+    // A null provider sends the relevance checks to the chat provider.
+    void set_fast_provider(const Ref<AIProvider> &p_provider);
+    Ref<AIProvider> get_fast_provider() const;
+    void restore_history(const Vector<HistoryMessage> &p_messages);
+
     AIBackend();
     ~AIBackend();
 };
 
-#endif // AI_BACKEND_H 
\ No newline at end of file
+#endif // AI_BACKEND_H
\ No newline at end of file
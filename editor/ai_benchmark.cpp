@@ -0,0 +1,304 @@
+#include "ai_benchmark.h"
+
+#include "ai_json_reader.h"
+#include "ai_payload_writer.h"
+#include "ai_trace.h"
+#include "core/io/json.h"
+#include "core/os/os.h"
+#include "godot_docs_retriever_bind.h"
+
+#ifdef UNIX_ENABLED
+#include <dlfcn.h>
+#endif
+
+// Godot's allocator keeps no call count, so allocations are counted by bench/alloc_counter.c when
+// it is preloaded. Returns -1 without it.
+static int64_t _get_alloc_count() {
+#ifdef UNIX_ENABLED
+    typedef unsigned long long (*AllocCountFunc)();
+    static AllocCountFunc alloc_count = (AllocCountFunc)dlsym(RTLD_DEFAULT, "ai_alloc_count");
+    if (alloc_count) {
+        return int64_t(alloc_count());
+    }
+#endif
+    return -1;
+}
+
+void AIBenchmark::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("benchmark_json_decode", "iterations", "content_length"), &AIBenchmark::benchmark_json_decode);
+    ClassDB::bind_method(D_METHOD("check_json_reader"), &AIBenchmark::check_json_reader);
+    ClassDB::bind_method(D_METHOD("benchmark_prompt_build", "iterations", "history_turns", "docs_results"), &AIBenchmark::benchmark_prompt_build);
+    ClassDB::bind_method(D_METHOD("get_trace_summary"), &AIBenchmark::get_trace_summary);
+    ClassDB::bind_method(D_METHOD("export_trace", "path"), &AIBenchmark::export_trace);
+    ClassDB::bind_method(D_METHOD("reset_trace"), &AIBenchmark::reset_trace);
+}
+
+Dictionary AIBenchmark::benchmark_json_decode(int p_iterations, int p_content_length) {
+    // A completion response shaped like the API's, with escapes and non-ASCII text in the reply.
+    String content;
+    const String sample = String::utf8("Use `add_child()` to attach a node.\n\"Quoted\" text, café and a tab\t. ");
+    while (content.length() < p_content_length) {
+        content += sample;
+    }
+    content = content.substr(0, p_content_length);
+
+    Dictionary message;
+    message["role"] = "assistant";
+    message["content"] = content;
+    Dictionary choice;
+    choice["index"] = 0;
+    choice["message"] = message;
+    choice["finish_reason"] = "stop";
+    Array choices;
+    choices.push_back(choice);
+    Dictionary usage;
+    usage["prompt_tokens"] = 120;
+    usage["completion_tokens"] = p_content_length / 4;
+    Dictionary response;
+    response["id"] = "chatcmpl-benchmark";
+    response["object"] = "chat.completion";
+    response["model"] = "gpt-3.5-turbo";
+    response["usage"] = usage;
+    response["choices"] = choices;
+
+    CharString utf8 = JSON::stringify(response).utf8();
+    PackedByteArray body;
+    body.resize(utf8.length());
+    memcpy(body.ptrw(), utf8.get_data(), utf8.length());
+
+    // The path AIBackend used before: copy to String, build the Variant tree, walk it.
+    uint64_t start = OS::get_singleton()->get_ticks_usec();
+    String parsed_content;
+    for (int i = 0; i < p_iterations; i++) {
+        String response_text;
+        response_text.parse_utf8((const char *)body.ptr(), body.size());
+        Dictionary parsed = JSON::parse_string(response_text);
+        Array parsed_choices = parsed.get("choices", Array());
+        Dictionary parsed_choice = parsed_choices[0];
+        Dictionary parsed_message = parsed_choice.get("message", Dictionary());
+        parsed_content = parsed_message.get("content", "");
+    }
+    uint64_t json_usec = OS::get_singleton()->get_ticks_usec() - start;
+
+    start = OS::get_singleton()->get_ticks_usec();
+    AIJsonReader reader;
+    String read_content;
+    for (int i = 0; i < p_iterations; i++) {
+        reader.extract_string(body, "choices.0.message.content", read_content);
+    }
+    uint64_t reader_usec = OS::get_singleton()->get_ticks_usec() - start;
+
+    Dictionary result;
+    result["iterations"] = p_iterations;
+    result["body_bytes"] = body.size();
+    result["json_parse_usec"] = json_usec;
+    result["reader_usec"] = reader_usec;
+    result["speedup"] = reader_usec > 0 ? double(json_usec) / reader_usec : 0.0;
+    result["match"] = parsed_content == read_content && read_content == content;
+    return result;
+}
+
+Dictionary AIBenchmark::check_json_reader() {
+    struct Case {
+        const char *json;
+        const char *path;
+        bool found;
+        const char32_t *expected;
+    };
+
+    static const Case cases[] = {
+        { R"({"choices":[{"message":{"role":"assistant","content":"hello"}}]})", "choices.0.message.content", true, U"hello" },
+        { R"({"choices":[{"message":{"content":""}}]})", "choices.0.message.content", true, U"" },
+        { R"({"a":"q\"b\\s\/n\nt\tr\rb\bf\f"})", "a", true, U"q\"b\\s/n\nt\tr\rb\bf\f" },
+        { R"({"a":"\u00e9\u4E2D\u0041"})", "a", true, U"\u00e9\u4e2dA" },
+        { "{\"a\":\"caf\xc3\xa9 \xe4\xb8\xad \xf0\x9f\x98\x80\"}", "a", true, U"caf\u00e9 \u4e2d \U0001F600" },
+        { R"({"a":"\ud83d\ude00!"})", "a", true, U"\U0001F600!" },
+        { R"({"a":"\uD83D\uDE00"})", "a", true, U"\U0001F600" },
+        // Unpaired surrogates cannot be encoded and become U+FFFD.
+        { R"({"a":"x\ud83dy"})", "a", true, U"x\uFFFDy" },
+        { R"({"a":"\ud83d\u0041"})", "a", true, U"\uFFFDA" },
+        { R"({"a":"\ude00"})", "a", true, U"\uFFFD" },
+        { R"({"a":"\u12"})", "a", false, nullptr },
+        { R"({"a":"\u12zz"})", "a", false, nullptr },
+        // Values off the path are skipped, including strings holding brackets and quotes.
+        { R"({"id":"x","meta":{"a":[1,{"b":"]}"}],"c":"\"}[","d":null},"choices":[{"index":0,"logprobs":null,"message":{"content":"ok"}}]})", "choices.0.message.content", true, U"ok" },
+        { R"({"choices":[{"message":{"content":"first"}},{"message":{"content":"second"}}]})", "choices.1.message.content", true, U"second" },
+        { R"({"choices":[[1,2],{"x":[]},"s",{"message":{"content":"fourth"}}]})", "choices.3.message.content", true, U"fourth" },
+        { " {\n \"choices\" : [ { \"message\" :\t{ \"content\" : \"spaced\" } } ] }\r\n", "choices.0.message.content", true, U"spaced" },
+        { R"({"contents":"no","content":"yes"})", "content", true, U"yes" },
+        // Not a string, or not there at all.
+        { R"({"choices":[{"message":{"content":null,"tool_calls":[]}}]})", "choices.0.message.content", false, nullptr },
+        { R"({"choices":[{"message":{"content":42}}]})", "choices.0.message.content", false, nullptr },
+        { R"({"choices":[{"message":{"role":"assistant"}}]})", "choices.0.message.content", false, nullptr },
+        { R"({"choices":[]})", "choices.0.message.content", false, nullptr },
+        { R"({"choices":[{"message":{"content":"only"}}]})", "choices.1.message.content", false, nullptr },
+        { R"({"error":{"message":"Rate limit reached","type":"requests"}})", "choices.0.message.content", false, nullptr },
+        { R"({"error":{"message":"Rate limit reached","type":"requests"}})", "error.message", true, U"Rate limit reached" },
+        { R"(["a"])", "content", false, nullptr },
+        { "", "content", false, nullptr },
+        { "not json", "content", false, nullptr },
+    };
+
+    AIJsonReader reader;
+    PackedStringArray failures;
+    int checks = 0;
+    for (const Case &c : cases) {
+        String value;
+        bool found = reader.extract_string((const uint8_t *)c.json, strlen(c.json), c.path, value);
+        checks++;
+        if (found != c.found || (found && value != String(c.expected))) {
+            failures.push_back(vformat("%s in %s: expected %s, got %s", c.path, String::utf8(c.json), c.found ? "\"" + String(c.expected) + "\"" : String("nothing"), found ? "\"" + value + "\"" : String("nothing")));
+        }
+    }
+
+    // A truncated body must never yield a wrong or partial value: the reader either finds the
+    // whole string or nothing.
+    const char *full = R"({"id":"x","meta":{"tags":["a","]"]},"choices":[{"message":{"content":"caf\u00e9 \"q\" \ud83d\ude00\n"}}],"usage":{"total":3}})";
+    String expected = U"caf\u00e9 \"q\" \U0001F600\n";
+    int full_length = strlen(full);
+    for (int length = 0; length <= full_length; length++) {
+        String value;
+        bool found = reader.extract_string((const uint8_t *)full, length, "choices.0.message.content", value);
+        checks++;
+        if (found && value != expected) {
+            failures.push_back(vformat("Truncated to %d bytes: got \"%s\"", length, value));
+        }
+        if (!found && length == full_length) {
+            failures.push_back("Untruncated body: content not found");
+        }
+    }
+
+    Dictionary result;
+    result["checks"] = checks;
+    result["failures"] = failures;
+    return result;
+}
+
+Dictionary AIBenchmark::benchmark_prompt_build(int p_iterations, int p_history_turns, int p_docs_results) {
+    // One chat turn: retrieved docs formatted into the context, then the request body built from
+    // the system prompt, the history and the new message, ready to send.
+    const String system_prompt = "You are a helpful assistant specialized in the Godot game engine. Answer with GDScript examples where useful.";
+    const String paragraph = String::utf8("Call `move_and_slide()` from `_physics_process()`. The \"velocity\" property is in pixels per second; café\n");
+    Array docs;
+    for (int i = 0; i < p_docs_results; i++) {
+        Dictionary doc;
+        doc["content"] = vformat("CharacterBody2D section %d\n", i) + paragraph.repeat(6);
+        doc["relevance"] = 0.9 - i * 0.05;
+        docs.push_back(doc);
+    }
+    Vector<String> history;
+    for (int i = 0; i < p_history_turns * 2; i++) {
+        history.push_back(paragraph.repeat(i % 2 ? 8 : 2));
+    }
+    const String message = "How do I make my character jump only when on the floor?";
+
+    // The path used before: String concatenation for the docs, a Variant tree for the messages,
+    // JSON::stringify, then the UTF-8 copy made for the request.
+    int64_t allocs_before = _get_alloc_count();
+    uint64_t start = OS::get_singleton()->get_ticks_usec();
+    PackedByteArray legacy_body;
+    for (int iteration = 0; iteration < p_iterations; iteration++) {
+        String formatted = "Here are the most relevant sections from the Godot documentation:\n\n";
+        for (int i = 0; i < docs.size(); i++) {
+            Dictionary doc = docs[i];
+            formatted += vformat("[Result %d] (Relevance: %.2f)\n", i + 1, (double)doc["relevance"]);
+            formatted += String(doc["content"]) + "\n\n";
+        }
+
+        Array messages;
+        Dictionary system_message;
+        system_message["role"] = "system";
+        system_message["content"] = system_prompt;
+        messages.push_back(system_message);
+        for (int i = 0; i < history.size(); i++) {
+            Dictionary history_message;
+            history_message["role"] = i % 2 ? "assistant" : "user";
+            history_message["content"] = history[i];
+            messages.push_back(history_message);
+        }
+        Dictionary user_message;
+        user_message["role"] = "user";
+        user_message["content"] = formatted + "\nPlease use this documentation to help answer the following question:\n\n" + message;
+        messages.push_back(user_message);
+
+        Dictionary request_data;
+        request_data["model"] = "gpt-3.5-turbo";
+        request_data["messages"] = messages;
+        request_data["temperature"] = 0.7;
+        request_data["max_tokens"] = 1000;
+        CharString utf8 = JSON::stringify(request_data).utf8();
+        legacy_body.resize(utf8.length());
+        memcpy(legacy_body.ptrw(), utf8.get_data(), utf8.length());
+    }
+    uint64_t legacy_usec = OS::get_singleton()->get_ticks_usec() - start;
+    int64_t legacy_allocs = allocs_before < 0 ? -1 : _get_alloc_count() - allocs_before;
+
+    // The current path, as the chat dock and AIBackend::_write_chat_request() take it: the docs
+    // kept as result parts, the history prefix serialized once and every part escaped straight into
+    // a writer reused across turns.
+    AIPayloadWriter prefix;
+    prefix.append("{\"model\":\"gpt-3.5-turbo\",\"temperature\":0.7,\"max_tokens\":1000,\"messages\":[{\"role\":\"system\",\"content\":");
+    prefix.append_json_string(system_prompt);
+    prefix.append("}");
+    for (int i = 0; i < history.size(); i++) {
+        prefix.append(i % 2 ? ",{\"role\":\"assistant\",\"content\":" : ",{\"role\":\"user\",\"content\":");
+        prefix.append_json_string(history[i]);
+        prefix.append("}");
+    }
+    AIPayloadWriter writer;
+    PackedByteArray writer_body;
+    PackedStringArray context;
+
+    allocs_before = _get_alloc_count();
+    start = OS::get_singleton()->get_ticks_usec();
+    for (int iteration = 0; iteration < p_iterations; iteration++) {
+        context.clear();
+        GodotDocsRetrieverBind::append_result_parts(docs, context);
+        context.push_back("\nPlease use this documentation to help answer the following question:\n\n");
+        writer.clear();
+        writer.append(prefix);
+        writer.append(",{\"role\":\"user\",\"content\":\"");
+        for (const String &part : context) {
+            writer.append_json_escaped(part);
+        }
+        writer.append_json_escaped(message);
+        writer.append("\"}]}");
+        writer_body = writer.to_byte_array();
+    }
+    uint64_t writer_usec = OS::get_singleton()->get_ticks_usec() - start;
+    int64_t writer_allocs = allocs_before < 0 ? -1 : _get_alloc_count() - allocs_before;
+
+    // Key order differs between the two bodies, so they are compared as parsed values.
+    String legacy_text;
+    legacy_text.parse_utf8((const char *)legacy_body.ptr(), legacy_body.size());
+    String writer_text;
+    writer_text.parse_utf8((const char *)writer_body.ptr(), writer_body.size());
+    Variant legacy_parsed = JSON::parse_string(legacy_text);
+    Variant writer_parsed = JSON::parse_string(writer_text);
+
+    Dictionary result;
+    result["iterations"] = p_iterations;
+    result["history_turns"] = p_history_turns;
+    result["docs_results"] = p_docs_results;
+    result["body_bytes"] = writer_body.size();
+    result["legacy_usec_per_turn"] = p_iterations > 0 ? double(legacy_usec) / p_iterations : 0.0;
+    result["writer_usec_per_turn"] = p_iterations > 0 ? double(writer_usec) / p_iterations : 0.0;
+    result["speedup"] = writer_usec > 0 ? double(legacy_usec) / writer_usec : 0.0;
+    result["legacy_allocs_per_turn"] = legacy_allocs < 0 || p_iterations == 0 ? -1.0 : double(legacy_allocs) / p_iterations;
+    result["writer_allocs_per_turn"] = writer_allocs < 0 || p_iterations == 0 ? -1.0 : double(writer_allocs) / p_iterations;
+    result["writer_growth_count"] = writer.get_growth_count();
+    result["match"] = legacy_parsed == writer_parsed;
+    return result;
+}
+
+Dictionary AIBenchmark::get_trace_summary() const {
+    return AITrace::get_summary();
+}
+
+Error AIBenchmark::export_trace(const String &p_path) const {
+    return AITrace::export_chrome_trace(p_path);
+}
+
+void AIBenchmark::reset_trace() {
+    AITrace::reset();
+}
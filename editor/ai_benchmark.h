@@ -0,0 +1,25 @@
+#ifndef AI_BENCHMARK_H
+#define AI_BENCHMARK_H
+
+#include "core/object/ref_counted.h"
+#include "core/variant/dictionary.h"
+
+// Micro-benchmarks for the AI assistant's hot paths, driven from the scripts in bench/.
+class AIBenchmark : public RefCounted {
+    GDCLASS(AIBenchmark, RefCounted);
+
+protected:
+    static void _bind_methods();
+
+public:
+    Dictionary benchmark_json_decode(int p_iterations, int p_content_length);
+    // Edge cases for AIJsonReader; returns the number of checks and a description of each failure.
+    Dictionary check_json_reader();
+    Dictionary benchmark_prompt_build(int p_iterations, int p_history_turns, int p_docs_results);
+
+    Dictionary get_trace_summary() const;
+    Error export_trace(const String &p_path) const;
+    void reset_trace();
+};
+
+#endif // AI_BENCHMARK_H
@@ -0,0 +1,285 @@
+#include "ai_editor_context.h"
+
+#include "editor/editor_data.h"
+#include "editor/editor_node.h"
+#include "editor/editor_settings.h"
+#include "editor/plugins/script_editor_plugin.h"
+#include "scene/main/scene_tree.h"
+
+bool AIEditorContext::is_enabled() {
+    if (!EditorSettings::get_singleton()) {
+        return false;
+    }
+    Variant include_setting = EditorSettings::get_singleton()->get_setting("interface/ai/include_editor_context");
+    return include_setting.get_type() != Variant::NIL && bool(include_setting);
+}
+
+void AIEditorContext::start() {
+    if (started || !EditorNode::get_singleton() || !SceneTree::get_singleton()) {
+        return;
+    }
+    started = true;
+
+    SceneTree *tree = SceneTree::get_singleton();
+    tree->connect("node_added", callable_mp(this, &AIEditorContext::_on_node_added));
+    tree->connect("node_removed", callable_mp(this, &AIEditorContext::_on_node_removed));
+    tree->connect("node_renamed", callable_mp(this, &AIEditorContext::_on_node_renamed));
+    EditorNode::get_singleton()->connect("scene_changed", callable_mp(this, &AIEditorContext::_on_scene_changed));
+    EditorNode::get_singleton()->get_editor_selection()->connect("selection_changed", callable_mp(this, &AIEditorContext::_on_selection_changed));
+    if (ScriptEditor::get_singleton()) {
+        ScriptEditor::get_singleton()->connect("editor_script_changed", callable_mp(this, &AIEditorContext::_on_script_changed));
+        script = ScriptEditor::get_singleton()->get_current_script();
+    }
+}
+
+void AIEditorContext::stop() {
+    if (!started) {
+        return;
+    }
+    started = false;
+
+    SceneTree *tree = SceneTree::get_singleton();
+    if (tree) {
+        tree->disconnect("node_added", callable_mp(this, &AIEditorContext::_on_node_added));
+        tree->disconnect("node_removed", callable_mp(this, &AIEditorContext::_on_node_removed));
+        tree->disconnect("node_renamed", callable_mp(this, &AIEditorContext::_on_node_renamed));
+    }
+    if (EditorNode::get_singleton()) {
+        EditorNode::get_singleton()->disconnect("scene_changed", callable_mp(this, &AIEditorContext::_on_scene_changed));
+        EditorNode::get_singleton()->get_editor_selection()->disconnect("selection_changed", callable_mp(this, &AIEditorContext::_on_selection_changed));
+    }
+    if (ScriptEditor::get_singleton()) {
+        ScriptEditor::get_singleton()->disconnect("editor_script_changed", callable_mp(this, &AIEditorContext::_on_script_changed));
+    }
+}
+
+bool AIEditorContext::_is_in_edited_scene(Node *p_node) const {
+    // node_added and friends fire for every node in the editor, including its own UI.
+    Node *edited_root = EditorNode::get_singleton()->get_edited_scene();
+    return edited_root && (p_node == edited_root || edited_root->is_ancestor_of(p_node));
+}
+
+void AIEditorContext::_record_scene_change(const String &p_change) {
+    if (scene_full_pending) {
+        return; // The next summary covers it anyway.
+    }
+    if (scene_changes.size() >= MAX_SCENE_CHANGES) {
+        scene_changes.clear();
+        scene_full_pending = true;
+        return;
+    }
+    scene_changes.push_back(p_change);
+}
+
+void AIEditorContext::_on_scene_changed() {
+    scene_changes.clear();
+    scene_full_pending = true;
+    selection_dirty = true;
+}
+
+void AIEditorContext::_on_node_added(Node *p_node) {
+    if (_is_in_edited_scene(p_node)) {
+        _record_scene_change("+ " + _describe_node(p_node));
+    }
+}
+
+void AIEditorContext::_on_node_removed(Node *p_node) {
+    if (_is_in_edited_scene(p_node)) {
+        Node *edited_root = EditorNode::get_singleton()->get_edited_scene();
+        _record_scene_change("- " + String(edited_root->get_path_to(p_node)));
+    }
+}
+
+void AIEditorContext::_on_node_renamed(Node *p_node) {
+    if (_is_in_edited_scene(p_node)) {
+        _record_scene_change("~ renamed " + _describe_node(p_node));
+    }
+}
+
+void AIEditorContext::_on_selection_changed() {
+    selection_dirty = true;
+}
+
+void AIEditorContext::_on_script_changed(const Ref<Script> &p_script) {
+    script = p_script;
+}
+
+String AIEditorContext::_describe_node(Node *p_node) const {
+    Node *edited_root = EditorNode::get_singleton()->get_edited_scene();
+    String text = edited_root ? String(edited_root->get_path_to(p_node)) : String(p_node->get_name());
+    text += " (" + p_node->get_class() + ")";
+
+    Ref<Script> node_script = p_node->get_script();
+    if (node_script.is_valid() && !node_script->get_path().is_empty()) {
+        text += " " + node_script->get_path().get_file();
+    }
+    if (p_node != edited_root && !p_node->get_scene_file_path().is_empty()) {
+        text += " instance of " + p_node->get_scene_file_path();
+    }
+    return text;
+}
+
+void AIEditorContext::_summarize_node(Node *p_node, Node *p_root, int p_depth, int &r_budget, String &r_text) const {
+    if (r_budget <= 0) {
+        return;
+    }
+    r_budget--;
+
+    r_text += String("  ").repeat(p_depth + 1) + p_node->get_name() + " (" + p_node->get_class() + ")";
+    Ref<Script> node_script = p_node->get_script();
+    if (node_script.is_valid() && !node_script->get_path().is_empty()) {
+        r_text += " " + node_script->get_path().get_file();
+    }
+    if (p_node != p_root && !p_node->get_scene_file_path().is_empty()) {
+        // Instanced scenes are shown collapsed, like in the scene dock.
+        r_text += " instance of " + p_node->get_scene_file_path() + "\n";
+        return;
+    }
+    r_text += "\n";
+
+    int child_count = p_node->get_child_count();
+    if (p_depth + 1 >= MAX_SCENE_DEPTH && child_count > 0) {
+        r_text += String("  ").repeat(p_depth + 2) + vformat("... %d children\n", child_count);
+        return;
+    }
+    for (int i = 0; i < child_count; i++) {
+        Node *child = p_node->get_child(i);
+        if (child->get_owner() != p_root) {
+            continue;
+        }
+        if (r_budget <= 0) {
+            r_text += String("  ").repeat(p_depth + 2) + "...\n";
+            return;
+        }
+        _summarize_node(child, p_root, p_depth + 1, r_budget, r_text);
+    }
+}
+
+String AIEditorContext::_summarize_scene() const {
+    Node *edited_root = EditorNode::get_singleton()->get_edited_scene();
+    if (!edited_root) {
+        return "Scene: none open\n";
+    }
+
+    String text = "Scene: " + (edited_root->get_scene_file_path().is_empty() ? String("(unsaved)") : edited_root->get_scene_file_path()) + "\n";
+    int budget = MAX_SCENE_NODES;
+    _summarize_node(edited_root, edited_root, 0, budget, text);
+    return text;
+}
+
+String AIEditorContext::_summarize_selection() const {
+    const List<Node *> &selected = EditorNode::get_singleton()->get_editor_selection()->get_selected_node_list();
+    if (selected.is_empty()) {
+        return "Selected: nothing\n";
+    }
+
+    String text = "Selected:";
+    int count = 0;
+    for (Node *node : selected) {
+        if (count++ >= MAX_SELECTED_NODES) {
+            text += vformat(" ... %d more", selected.size() - MAX_SELECTED_NODES);
+            break;
+        }
+        text += (count > 1 ? ", " : " ") + _describe_node(node);
+    }
+    return text + "\n";
+}
+
+String AIEditorContext::_summarize_script() const {
+    String text = "Script: " + script->get_path();
+    StringName base = script->get_instance_base_type();
+    if (base != StringName()) {
+        text += " extends " + String(base);
+    }
+    text += "\n";
+
+    List<MethodInfo> methods;
+    script->get_script_method_list(&methods);
+    List<PropertyInfo> properties;
+    script->get_script_property_list(&properties);
+    List<MethodInfo> signals;
+    script->get_script_signal_list(&signals);
+
+    int members = 0;
+    if (!properties.is_empty()) {
+        text += "  properties:";
+        for (const PropertyInfo &property : properties) {
+            if ((property.usage & (PROPERTY_USAGE_CATEGORY | PROPERTY_USAGE_GROUP | PROPERTY_USAGE_SUBGROUP)) || members++ >= MAX_SCRIPT_MEMBERS) {
+                continue;
+            }
+            text += " " + property.name;
+        }
+        text += "\n";
+    }
+    if (!signals.is_empty()) {
+        text += "  signals:";
+        for (const MethodInfo &signal : signals) {
+            if (members++ < MAX_SCRIPT_MEMBERS) {
+                text += " " + signal.name;
+            }
+        }
+        text += "\n";
+    }
+    if (!methods.is_empty()) {
+        text += "  methods:";
+        for (const MethodInfo &method : methods) {
+            if (members++ < MAX_SCRIPT_MEMBERS) {
+                text += " " + method.name + "()";
+            }
+        }
+        text += "\n";
+    }
+    return text;
+}
+
+String AIEditorContext::take_context() {
+    if (!started) {
+        return String();
+    }
+
+    String text;
+    if (scene_full_pending) {
+        text += _summarize_scene();
+        scene_full_pending = false;
+    } else if (!scene_changes.is_empty()) {
+        text += "Scene changes since the last message:\n";
+        for (const String &change : scene_changes) {
+            text += "  " + change + "\n";
+        }
+    }
+    scene_changes.clear();
+
+    if (selection_dirty) {
+        selection_summary = _summarize_selection();
+        selection_dirty = false;
+    }
+    if (selection_summary != sent_selection_summary) {
+        text += selection_summary;
+        sent_selection_summary = selection_summary;
+    }
+
+    // Script edits do not signal anything, so the source is hashed instead. That is one pass over
+    // a single file, not over the project.
+    if (script.is_valid() && !script->get_path().is_empty()) {
+        uint32_t script_hash = script->get_source_code().hash();
+        if (script_hash != sent_script_hash || script->get_path() != sent_script_path) {
+            text += _summarize_script();
+            sent_script_hash = script_hash;
+            sent_script_path = script->get_path();
+        }
+    }
+
+    return text;
+}
+
+void AIEditorContext::reset_sent() {
+    scene_full_pending = true;
+    scene_changes.clear();
+    sent_selection_summary = String();
+    sent_script_hash = 0;
+    sent_script_path = String();
+}
+
+AIEditorContext::~AIEditorContext() {
+    stop();
+}
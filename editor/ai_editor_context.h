@@ -0,0 +1,72 @@
+#ifndef AI_EDITOR_CONTEXT_H
+#define AI_EDITOR_CONTEXT_H
+
+#include "core/object/ref_counted.h"
+#include "core/object/script_language.h"
+#include "core/templates/local_vector.h"
+
+class Node;
+
+// Compact description of what the user is looking at in the editor, for the assistant prompt.
+//
+// Nothing is walked per message. Editor signals only mark sections dirty or record a scene change,
+// and take_context() rebuilds just the dirty sections. Sections that have not changed since the
+// previous turn are left out, and edits to the open scene are sent as a list of added, removed and
+// renamed nodes instead of the whole tree again.
+class AIEditorContext : public RefCounted {
+    GDCLASS(AIEditorContext, RefCounted);
+
+    enum {
+        MAX_SCENE_NODES = 200,
+        MAX_SCENE_DEPTH = 8,
+        MAX_SCENE_CHANGES = 50,
+        MAX_SELECTED_NODES = 20,
+        MAX_SCRIPT_MEMBERS = 40,
+    };
+
+    bool started = false;
+
+    // A full scene summary is sent on the first turn, after a scene switch, or when more changes
+    // piled up than are worth listing.
+    bool scene_full_pending = true;
+    LocalVector<String> scene_changes;
+
+    bool selection_dirty = true;
+    String selection_summary;
+    String sent_selection_summary;
+
+    Ref<Script> script;
+    uint32_t sent_script_hash = 0;
+    String sent_script_path;
+
+    bool _is_in_edited_scene(Node *p_node) const;
+    void _record_scene_change(const String &p_change);
+    void _on_scene_changed();
+    void _on_node_added(Node *p_node);
+    void _on_node_removed(Node *p_node);
+    void _on_node_renamed(Node *p_node);
+    void _on_selection_changed();
+    void _on_script_changed(const Ref<Script> &p_script);
+
+    String _describe_node(Node *p_node) const;
+    void _summarize_node(Node *p_node, Node *p_root, int p_depth, int &r_budget, String &r_text) const;
+    String _summarize_scene() const;
+    String _summarize_selection() const;
+    String _summarize_script() const;
+
+public:
+    static bool is_enabled();
+
+    void start();
+    void stop();
+
+    // Everything that changed since the previous call, or an empty string.
+    String take_context();
+    // Forgets what was taken before, so the next take_context() describes everything again. For
+    // when a taken delta never reached the conversation history.
+    void reset_sent();
+
+    ~AIEditorContext();
+};
+
+#endif // AI_EDITOR_CONTEXT_H
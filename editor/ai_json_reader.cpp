@@ -0,0 +1,271 @@
+#include "ai_json_reader.h"
+
+void AIJsonReader::_skip_whitespace() {
+    while (pos < size && (data[pos] == ' ' || data[pos] == '\t' || data[pos] == '\n' || data[pos] == '\r')) {
+        pos++;
+    }
+}
+
+bool AIJsonReader::_skip_string() {
+    // Expects `pos` on the opening quote and leaves it after the closing one.
+    pos++;
+    while (pos < size) {
+        uint8_t c = data[pos++];
+        if (c == '\\') {
+            pos++;
+        } else if (c == '"') {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool AIJsonReader::_skip_value() {
+    _skip_whitespace();
+    if (pos >= size) {
+        return false;
+    }
+
+    uint8_t c = data[pos];
+    if (c == '"') {
+        return _skip_string();
+    }
+
+    if (c == '{' || c == '[') {
+        // Only brackets and strings matter for finding the end of a container.
+        int depth = 0;
+        while (pos < size) {
+            c = data[pos];
+            if (c == '"') {
+                if (!_skip_string()) {
+                    return false;
+                }
+                continue;
+            }
+            if (c == '{' || c == '[') {
+                depth++;
+            } else if (c == '}' || c == ']') {
+                depth--;
+                if (depth == 0) {
+                    pos++;
+                    return true;
+                }
+            }
+            pos++;
+        }
+        return false;
+    }
+
+    // Number, true, false or null.
+    while (pos < size && data[pos] != ',' && data[pos] != '}' && data[pos] != ']') {
+        pos++;
+    }
+    return true;
+}
+
+bool AIJsonReader::_find_key(const char *p_key, int p_key_length) {
+    _skip_whitespace();
+    if (pos >= size || data[pos] != '{') {
+        return false;
+    }
+    pos++;
+
+    while (true) {
+        _skip_whitespace();
+        if (pos >= size || data[pos] != '"') {
+            return false; // End of object or malformed input.
+        }
+
+        int key_start = pos + 1;
+        if (!_skip_string()) {
+            return false;
+        }
+        int key_length = pos - 1 - key_start;
+        bool match = key_length == p_key_length && memcmp(data + key_start, p_key, p_key_length) == 0;
+
+        _skip_whitespace();
+        if (pos >= size || data[pos] != ':') {
+            return false;
+        }
+        pos++;
+        _skip_whitespace();
+
+        if (match) {
+            return true;
+        }
+        if (!_skip_value()) {
+            return false;
+        }
+        _skip_whitespace();
+        if (pos < size && data[pos] == ',') {
+            pos++;
+        }
+    }
+}
+
+bool AIJsonReader::_find_index(int p_index) {
+    _skip_whitespace();
+    if (pos >= size || data[pos] != '[') {
+        return false;
+    }
+    pos++;
+
+    for (int i = 0; i < p_index; i++) {
+        _skip_whitespace();
+        if (pos >= size || data[pos] == ']' || !_skip_value()) {
+            return false;
+        }
+        _skip_whitespace();
+        if (pos >= size || data[pos] != ',') {
+            return false;
+        }
+        pos++;
+    }
+    _skip_whitespace();
+    return pos < size && data[pos] != ']';
+}
+
+bool AIJsonReader::_read_string(String &r_value) {
+    _skip_whitespace();
+    if (pos >= size || data[pos] != '"') {
+        return false;
+    }
+
+    int start = pos + 1;
+    int end = start;
+    bool escaped = false;
+    while (end < size && data[end] != '"') {
+        if (data[end] == '\\') {
+            escaped = true;
+            end++;
+        }
+        end++;
+    }
+    if (end >= size) {
+        return false;
+    }
+
+    if (!escaped) {
+        r_value.parse_utf8((const char *)data + start, end - start);
+        return true;
+    }
+
+    // Unescape into UTF-8 so the whole string is still converted with a single parse_utf8().
+    scratch.clear();
+    scratch.reserve(end - start);
+    for (int i = start; i < end; i++) {
+        char c = data[i];
+        if (c != '\\') {
+            scratch.push_back(c);
+            continue;
+        }
+
+        i++;
+        switch (data[i]) {
+            case 'n':
+                scratch.push_back('\n');
+                break;
+            case 't':
+                scratch.push_back('\t');
+                break;
+            case 'r':
+                scratch.push_back('\r');
+                break;
+            case 'b':
+                scratch.push_back('\b');
+                break;
+            case 'f':
+                scratch.push_back('\f');
+                break;
+            case 'u': {
+                if (i + 4 >= end) {
+                    return false;
+                }
+                char32_t codepoint = 0;
+                for (int j = 1; j <= 4; j++) {
+                    char32_t digit = data[i + j];
+                    if (!is_hex_digit(digit)) {
+                        return false;
+                    }
+                    codepoint = (codepoint << 4) | (is_digit(digit) ? digit - '0' : (digit | 0x20) - 'a' + 10);
+                }
+                i += 4;
+
+                // Surrogate pair.
+                if (codepoint >= 0xD800 && codepoint <= 0xDBFF && i + 6 < end && data[i + 1] == '\\' && data[i + 2] == 'u') {
+                    char32_t low = 0;
+                    for (int j = 3; j <= 6; j++) {
+                        char32_t digit = data[i + j];
+                        if (!is_hex_digit(digit)) {
+                            return false;
+                        }
+                        low = (low << 4) | (is_digit(digit) ? digit - '0' : (digit | 0x20) - 'a' + 10);
+                    }
+                    if (low >= 0xDC00 && low <= 0xDFFF) {
+                        codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+                        i += 6;
+                    }
+                }
+                if (codepoint >= 0xD800 && codepoint <= 0xDFFF) {
+                    codepoint = 0xFFFD; // Unpaired surrogate, which UTF-8 cannot encode.
+                }
+
+                if (codepoint < 0x80) {
+                    scratch.push_back(char(codepoint));
+                } else if (codepoint < 0x800) {
+                    scratch.push_back(char(0xC0 | (codepoint >> 6)));
+                    scratch.push_back(char(0x80 | (codepoint & 0x3F)));
+                } else if (codepoint < 0x10000) {
+                    scratch.push_back(char(0xE0 | (codepoint >> 12)));
+                    scratch.push_back(char(0x80 | ((codepoint >> 6) & 0x3F)));
+                    scratch.push_back(char(0x80 | (codepoint & 0x3F)));
+                } else {
+                    scratch.push_back(char(0xF0 | (codepoint >> 18)));
+                    scratch.push_back(char(0x80 | ((codepoint >> 12) & 0x3F)));
+                    scratch.push_back(char(0x80 | ((codepoint >> 6) & 0x3F)));
+                    scratch.push_back(char(0x80 | (codepoint & 0x3F)));
+                }
+            } break;
+            default:
+                // \" \\ \/
+                scratch.push_back(data[i]);
+                break;
+        }
+    }
+
+    r_value.parse_utf8(scratch.ptr(), scratch.size());
+    return true;
+}
+
+bool AIJsonReader::extract_string(const uint8_t *p_data, int p_size, const char *p_path, String &r_value) {
+    data = p_data;
+    size = p_size;
+    pos = 0;
+
+    const char *element = p_path;
+    while (*element) {
+        const char *element_end = element;
+        while (*element_end && *element_end != '.') {
+            element_end++;
+        }
+        int element_length = element_end - element;
+
+        bool is_index = element_length > 0;
+        int index = 0;
+        for (const char *c = element; c < element_end; c++) {
+            if (!is_digit(*c)) {
+                is_index = false;
+                break;
+            }
+            index = index * 10 + (*c - '0');
+        }
+
+        if (!(is_index ? _find_index(index) : _find_key(element, element_length))) {
+            return false;
+        }
+
+        element = *element_end ? element_end + 1 : element_end;
+    }
+
+    return _read_string(r_value);
+}
@@ -0,0 +1,33 @@
+#ifndef AI_JSON_READER_H
+#define AI_JSON_READER_H
+
+#include "core/string/ustring.h"
+#include "core/templates/local_vector.h"
+#include "core/variant/variant.h"
+
+// Pulls single string fields out of a JSON document without building a Variant tree.
+//
+// Paths are dot separated object keys and array indices, e.g. "choices.0.message.content".
+// Everything off the path is skipped without decoding. Strings without escapes are decoded
+// straight from the input buffer; escaped ones go through one reusable scratch buffer.
+class AIJsonReader {
+    const uint8_t *data = nullptr;
+    int size = 0;
+    int pos = 0;
+    LocalVector<char> scratch;
+
+    void _skip_whitespace();
+    bool _skip_string();
+    bool _skip_value();
+    bool _find_key(const char *p_key, int p_key_length);
+    bool _find_index(int p_index);
+    bool _read_string(String &r_value);
+
+public:
+    bool extract_string(const uint8_t *p_data, int p_size, const char *p_path, String &r_value);
+    bool extract_string(const PackedByteArray &p_body, const char *p_path, String &r_value) {
+        return extract_string(p_body.ptr(), p_body.size(), p_path, r_value);
+    }
+};
+
+#endif // AI_JSON_READER_H
@@ -0,0 +1,139 @@
+#include "ai_line_diff.h"
+
+#include "core/templates/local_vector.h"
+
+Vector<AILineDiff::Line> AILineDiff::compute(const String &p_old, const String &p_new) {
+    Vector<String> old_lines = p_old.split("\n");
+    Vector<String> new_lines = p_new.split("\n");
+    int old_count = old_lines.size();
+    int new_count = new_lines.size();
+
+    // Edits usually touch a few places, so the unchanged head and tail are skipped before aligning.
+    int head = 0;
+    while (head < old_count && head < new_count && old_lines[head] == new_lines[head]) {
+        head++;
+    }
+    int tail = 0;
+    while (tail < old_count - head && tail < new_count - head && old_lines[old_count - 1 - tail] == new_lines[new_count - 1 - tail]) {
+        tail++;
+    }
+
+    Vector<Line> lines;
+    for (int i = 0; i < head; i++) {
+        lines.push_back({ OP_EQUAL, old_lines[i] });
+    }
+
+    int n = old_count - head - tail;
+    int m = new_count - head - tail;
+    int i = 0;
+    int j = 0;
+    if (n > 0 && m > 0 && int64_t(n) * m <= MAX_ALIGNED_CELLS) {
+        // Longest common subsequence of the changed middle. With at most MAX_ALIGNED_CELLS cells
+        // the shorter side has at most 1024 lines, so lengths fit in 16 bits.
+        LocalVector<uint32_t> old_hashes;
+        old_hashes.resize(n);
+        for (int k = 0; k < n; k++) {
+            old_hashes[k] = old_lines[head + k].hash();
+        }
+        LocalVector<uint32_t> new_hashes;
+        new_hashes.resize(m);
+        for (int k = 0; k < m; k++) {
+            new_hashes[k] = new_lines[head + k].hash();
+        }
+
+        int width = m + 1;
+        LocalVector<uint16_t> lcs;
+        lcs.resize((n + 1) * width);
+        memset(lcs.ptr(), 0, lcs.size() * sizeof(uint16_t));
+        for (int a = n - 1; a >= 0; a--) {
+            for (int b = m - 1; b >= 0; b--) {
+                if (old_hashes[a] == new_hashes[b] && old_lines[head + a] == new_lines[head + b]) {
+                    lcs[a * width + b] = lcs[(a + 1) * width + b + 1] + 1;
+                } else {
+                    lcs[a * width + b] = MAX(lcs[(a + 1) * width + b], lcs[a * width + b + 1]);
+                }
+            }
+        }
+
+        while (i < n && j < m) {
+            if (old_hashes[i] == new_hashes[j] && old_lines[head + i] == new_lines[head + j]) {
+                lines.push_back({ OP_EQUAL, old_lines[head + i] });
+                i++;
+                j++;
+            } else if (lcs[(i + 1) * width + j] >= lcs[i * width + j + 1]) {
+                lines.push_back({ OP_REMOVE, old_lines[head + i] });
+                i++;
+            } else {
+                lines.push_back({ OP_ADD, new_lines[head + j] });
+                j++;
+            }
+        }
+    }
+    // Whatever is left, or the whole middle when it is too large to align, is replaced.
+    for (; i < n; i++) {
+        lines.push_back({ OP_REMOVE, old_lines[head + i] });
+    }
+    for (; j < m; j++) {
+        lines.push_back({ OP_ADD, new_lines[head + j] });
+    }
+
+    for (int k = old_count - tail; k < old_count; k++) {
+        lines.push_back({ OP_EQUAL, old_lines[k] });
+    }
+    return lines;
+}
+
+String AILineDiff::format(const Vector<Line> &p_lines, int p_context) {
+    int count = p_lines.size();
+    LocalVector<uint8_t> visible;
+    visible.resize(count);
+    int last_change = -p_context - 1;
+    for (int i = 0; i < count; i++) {
+        if (p_lines[i].op != OP_EQUAL) {
+            last_change = i;
+        }
+        visible[i] = i - last_change <= p_context;
+    }
+    int next_change = count + p_context + 1;
+    for (int i = count - 1; i >= 0; i--) {
+        if (p_lines[i].op != OP_EQUAL) {
+            next_change = i;
+        }
+        visible[i] = visible[i] || next_change - i <= p_context;
+    }
+
+    String text;
+    int old_line = 1;
+    int new_line = 1;
+    bool in_hunk = false;
+    for (int i = 0; i < count; i++) {
+        const Line &line = p_lines[i];
+        if (visible[i]) {
+            if (!in_hunk) {
+                text += vformat("@@ -%d +%d @@\n", old_line, new_line);
+            }
+            text += (line.op == OP_ADD ? "+" : (line.op == OP_REMOVE ? "-" : " ")) + line.text + "\n";
+        }
+        in_hunk = visible[i];
+
+        if (line.op != OP_ADD) {
+            old_line++;
+        }
+        if (line.op != OP_REMOVE) {
+            new_line++;
+        }
+    }
+    return text;
+}
+
+void AILineDiff::count_changes(const Vector<Line> &p_lines, int &r_added, int &r_removed) {
+    r_added = 0;
+    r_removed = 0;
+    for (const Line &line : p_lines) {
+        if (line.op == OP_ADD) {
+            r_added++;
+        } else if (line.op == OP_REMOVE) {
+            r_removed++;
+        }
+    }
+}
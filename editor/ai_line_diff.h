@@ -0,0 +1,32 @@
+#ifndef AI_LINE_DIFF_H
+#define AI_LINE_DIFF_H
+
+#include "core/string/ustring.h"
+#include "core/templates/vector.h"
+
+// Line diff between two versions of a file, used to preview generated edits before they are applied.
+class AILineDiff {
+public:
+    enum Op {
+        OP_EQUAL,
+        OP_ADD,
+        OP_REMOVE,
+    };
+
+    struct Line {
+        Op op = OP_EQUAL;
+        String text;
+    };
+
+private:
+    // Above this many line pairs the changed middle is shown as replaced instead of being aligned.
+    static const int MAX_ALIGNED_CELLS = 1 << 20;
+
+public:
+    static Vector<Line> compute(const String &p_old, const String &p_new);
+    // Changed lines with p_context unchanged lines around them, in unified diff style.
+    static String format(const Vector<Line> &p_lines, int p_context = 2);
+    static void count_changes(const Vector<Line> &p_lines, int &r_added, int &r_removed);
+};
+
+#endif // AI_LINE_DIFF_H
@@ -0,0 +1,149 @@
+#include "ai_metrics_panel.h"
+
+#include "ai_trace.h"
+#include "editor/debugger/editor_debugger_node.h"
+#include "editor/debugger/script_editor_debugger.h"
+#include "editor/gui/editor_file_dialog.h"
+#include "editor/themes/editor_scale.h"
+#include "scene/gui/button.h"
+#include "scene/gui/tree.h"
+#include "scene/main/timer.h"
+
+AIMetricsPanel *AIMetricsPanel::singleton = nullptr;
+
+void AIMetricsPanel::install() {
+    if (singleton) {
+        return;
+    }
+    singleton = memnew(AIMetricsPanel);
+    EditorDebuggerNode::get_singleton()->get_default_debugger()->add_debugger_tab(singleton);
+}
+
+void AIMetricsPanel::_notification(int p_what) {
+    switch (p_what) {
+        case NOTIFICATION_VISIBILITY_CHANGED: {
+            // Only poll the counters while the tab is on screen.
+            if (is_visible_in_tree()) {
+                _refresh();
+                refresh_timer->start();
+            } else {
+                refresh_timer->stop();
+            }
+        } break;
+
+        case NOTIFICATION_PREDELETE: {
+            if (singleton == this) {
+                singleton = nullptr;
+            }
+        } break;
+    }
+}
+
+static String _format_msec(uint64_t p_usec) {
+    return String::num(p_usec / 1000.0, 2);
+}
+
+void AIMetricsPanel::_refresh() {
+    Dictionary summary = AITrace::get_summary();
+
+    span_tree->clear();
+    TreeItem *span_root = span_tree->create_item();
+    Dictionary spans = summary["spans"];
+    for (int i = 0; i < AITrace::SPAN_MAX; i++) {
+        Dictionary span = spans[AITrace::get_span_name(AITrace::Span(i))];
+        TreeItem *item = span_tree->create_item(span_root);
+        item->set_text(0, AITrace::get_span_name(AITrace::Span(i)));
+        item->set_text(1, itos(span["count"]));
+        item->set_text(2, _format_msec(span["mean_usec"]));
+        item->set_text(3, _format_msec(span["p50_usec"]));
+        item->set_text(4, _format_msec(span["p90_usec"]));
+        item->set_text(5, _format_msec(span["p99_usec"]));
+        item->set_text(6, _format_msec(span["max_usec"]));
+    }
+
+    cache_tree->clear();
+    TreeItem *cache_root = cache_tree->create_item();
+    Dictionary caches = summary["caches"];
+    for (int i = 0; i < AITrace::CACHE_MAX; i++) {
+        Dictionary cache = caches[AITrace::get_cache_name(AITrace::Cache(i))];
+        TreeItem *item = cache_tree->create_item(cache_root);
+        item->set_text(0, AITrace::get_cache_name(AITrace::Cache(i)));
+        item->set_text(1, itos(cache["hits"]));
+        item->set_text(2, itos(cache["misses"]));
+        item->set_text(3, String::num(double(cache["hit_rate"]) * 100.0, 1) + "%");
+    }
+}
+
+void AIMetricsPanel::_export_pressed() {
+    export_dialog->popup_file_dialog();
+}
+
+void AIMetricsPanel::_export_path_selected(const String &p_path) {
+    Error err = AITrace::export_chrome_trace(p_path);
+    if (err != OK) {
+        ERR_PRINT("Failed to export AI trace to " + p_path);
+    }
+}
+
+void AIMetricsPanel::_reset_pressed() {
+    AITrace::reset();
+    _refresh();
+}
+
+AIMetricsPanel::AIMetricsPanel() {
+    set_name("AI Metrics");
+    add_theme_constant_override("separation", 4 * EDSCALE);
+
+    HBoxContainer *toolbar = memnew(HBoxContainer);
+    add_child(toolbar);
+
+    export_button = memnew(Button);
+    export_button->set_text("Export Chrome Trace...");
+    export_button->connect("pressed", callable_mp(this, &AIMetricsPanel::_export_pressed));
+    toolbar->add_child(export_button);
+
+    reset_button = memnew(Button);
+    reset_button->set_text("Reset");
+    reset_button->connect("pressed", callable_mp(this, &AIMetricsPanel::_reset_pressed));
+    toolbar->add_child(reset_button);
+
+    // Span latencies, in milliseconds.
+    span_tree = memnew(Tree);
+    span_tree->set_v_size_flags(SIZE_EXPAND_FILL);
+    span_tree->set_hide_root(true);
+    span_tree->set_columns(7);
+    span_tree->set_column_titles_visible(true);
+    const char *span_titles[] = { "Span", "Count", "Mean (ms)", "p50 (ms)", "p90 (ms)", "p99 (ms)", "Max (ms)" };
+    for (int i = 0; i < 7; i++) {
+        span_tree->set_column_title(i, span_titles[i]);
+        span_tree->set_column_expand(i, i == 0);
+        span_tree->set_column_custom_minimum_width(i, 80 * EDSCALE);
+    }
+    add_child(span_tree);
+
+    cache_tree = memnew(Tree);
+    cache_tree->set_v_size_flags(SIZE_EXPAND_FILL);
+    cache_tree->set_hide_root(true);
+    cache_tree->set_columns(4);
+    cache_tree->set_column_titles_visible(true);
+    const char *cache_titles[] = { "Cache", "Hits", "Misses", "Hit Rate" };
+    for (int i = 0; i < 4; i++) {
+        cache_tree->set_column_title(i, cache_titles[i]);
+        cache_tree->set_column_expand(i, i == 0);
+        cache_tree->set_column_custom_minimum_width(i, 80 * EDSCALE);
+    }
+    add_child(cache_tree);
+
+    refresh_timer = memnew(Timer);
+    refresh_timer->set_wait_time(1.0);
+    refresh_timer->connect("timeout", callable_mp(this, &AIMetricsPanel::_refresh));
+    add_child(refresh_timer);
+
+    export_dialog = memnew(EditorFileDialog);
+    export_dialog->set_file_mode(EditorFileDialog::FILE_MODE_SAVE_FILE);
+    export_dialog->set_access(EditorFileDialog::ACCESS_FILESYSTEM);
+    export_dialog->add_filter("*.json", "Chrome Trace");
+    export_dialog->set_current_file("ai_trace.json");
+    export_dialog->connect("file_selected", callable_mp(this, &AIMetricsPanel::_export_path_selected));
+    add_child(export_dialog);
+}
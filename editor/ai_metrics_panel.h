@@ -0,0 +1,39 @@
+#ifndef AI_METRICS_PANEL_H
+#define AI_METRICS_PANEL_H
+
+#include "scene/gui/box_container.h"
+
+class Button;
+class EditorFileDialog;
+class Timer;
+class Tree;
+
+// Debugger tab showing the AITrace span percentiles and cache hit rates.
+class AIMetricsPanel : public VBoxContainer {
+    GDCLASS(AIMetricsPanel, VBoxContainer);
+
+private:
+    static AIMetricsPanel *singleton;
+
+    Tree *span_tree = nullptr;
+    Tree *cache_tree = nullptr;
+    Button *export_button = nullptr;
+    Button *reset_button = nullptr;
+    Timer *refresh_timer = nullptr;
+    EditorFileDialog *export_dialog = nullptr;
+
+    void _refresh();
+    void _export_pressed();
+    void _export_path_selected(const String &p_path);
+    void _reset_pressed();
+
+protected:
+    void _notification(int p_what);
+
+public:
+    static void install();
+
+    AIMetricsPanel();
+};
+
+#endif // AI_METRICS_PANEL_H
@@ -0,0 +1,187 @@
+#include "ai_payload_writer.h"
+
+#include "core/os/memory.h"
+
+#include <stdio.h>
+
+void AIPayloadWriter::_grow(uint32_t p_extra) {
+    uint32_t new_capacity = MAX(MAX(capacity * 2, 256u), used + p_extra);
+    data = (uint8_t *)memrealloc(data, new_capacity);
+    capacity = new_capacity;
+    growth_count++;
+}
+
+void AIPayloadWriter::reserve(uint32_t p_capacity) {
+    if (p_capacity > capacity) {
+        data = (uint8_t *)memrealloc(data, p_capacity);
+        capacity = p_capacity;
+        growth_count++;
+    }
+}
+
+void AIPayloadWriter::append(const char *p_ascii) {
+    append((const uint8_t *)p_ascii, strlen(p_ascii));
+}
+
+void AIPayloadWriter::append(const uint8_t *p_data, uint32_t p_length) {
+    if (p_length > 0) {
+        memcpy(_extend(p_length), p_data, p_length);
+    }
+}
+
+void AIPayloadWriter::append(const String &p_text) {
+    _append_utf8(p_text.ptr(), p_text.length());
+}
+
+void AIPayloadWriter::_append_utf8(const char32_t *p_text, int p_length) {
+    // Worst case is four bytes per character; give back what was not used.
+    uint8_t *dst = _extend(p_length * 4);
+    uint8_t *start = dst;
+    for (int i = 0; i < p_length; i++) {
+        char32_t c = p_text[i];
+        if (c < 0x80) {
+            *dst++ = uint8_t(c);
+        } else if (c < 0x800) {
+            *dst++ = uint8_t(0xC0 | (c >> 6));
+            *dst++ = uint8_t(0x80 | (c & 0x3F));
+        } else if (c < 0x10000) {
+            *dst++ = uint8_t(0xE0 | (c >> 12));
+            *dst++ = uint8_t(0x80 | ((c >> 6) & 0x3F));
+            *dst++ = uint8_t(0x80 | (c & 0x3F));
+        } else {
+            *dst++ = uint8_t(0xF0 | (c >> 18));
+            *dst++ = uint8_t(0x80 | ((c >> 12) & 0x3F));
+            *dst++ = uint8_t(0x80 | ((c >> 6) & 0x3F));
+            *dst++ = uint8_t(0x80 | (c & 0x3F));
+        }
+    }
+    used -= p_length * 4 - uint32_t(dst - start);
+}
+
+void AIPayloadWriter::append_int(int64_t p_value) {
+    char buffer[32];
+    int length = snprintf(buffer, sizeof(buffer), "%lld", (long long)p_value);
+    append((const uint8_t *)buffer, length);
+}
+
+void AIPayloadWriter::append_float(double p_value, int p_decimals) {
+    char buffer[64];
+    int length = p_decimals < 0 ? snprintf(buffer, sizeof(buffer), "%.6g", p_value) : snprintf(buffer, sizeof(buffer), "%.*f", p_decimals, p_value);
+    append((const uint8_t *)buffer, length);
+}
+
+void AIPayloadWriter::_append_escaped(const char32_t *p_text, int p_length) {
+    static const char hex[] = "0123456789abcdef";
+    int run_start = 0;
+    for (int i = 0; i < p_length; i++) {
+        char32_t c = p_text[i];
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        // Characters that need no escaping are copied in runs.
+        if (i > run_start) {
+            _append_utf8(p_text + run_start, i - run_start);
+        }
+        run_start = i + 1;
+
+        switch (c) {
+            case '"':
+                append("\\\"");
+                break;
+            case '\\':
+                append("\\\\");
+                break;
+            case '\n':
+                append("\\n");
+                break;
+            case '\r':
+                append("\\r");
+                break;
+            case '\t':
+                append("\\t");
+                break;
+            case '\b':
+                append("\\b");
+                break;
+            case '\f':
+                append("\\f");
+                break;
+            default: {
+                uint8_t *dst = _extend(6);
+                memcpy(dst, "\\u00", 4);
+                dst[4] = hex[(c >> 4) & 0xF];
+                dst[5] = hex[c & 0xF];
+            } break;
+        }
+    }
+    if (p_length > run_start) {
+        _append_utf8(p_text + run_start, p_length - run_start);
+    }
+}
+
+void AIPayloadWriter::append_json_escaped(const String &p_text) {
+    _append_escaped(p_text.ptr(), p_text.length());
+}
+
+void AIPayloadWriter::append_json_escaped(const char *p_utf8) {
+    // Multi-byte UTF-8 sequences never contain bytes below 0x80, so they pass through untouched.
+    static const char hex[] = "0123456789abcdef";
+    const char *run_start = p_utf8;
+    const char *c = p_utf8;
+    for (; *c; c++) {
+        uint8_t byte = uint8_t(*c);
+        if (byte >= 0x20 && byte != '"' && byte != '\\') {
+            continue;
+        }
+        append((const uint8_t *)run_start, c - run_start);
+        run_start = c + 1;
+        if (byte == '"' || byte == '\\') {
+            uint8_t *dst = _extend(2);
+            dst[0] = '\\';
+            dst[1] = byte;
+        } else if (byte == '\n') {
+            append("\\n");
+        } else if (byte == '\t') {
+            append("\\t");
+        } else {
+            uint8_t *dst = _extend(6);
+            memcpy(dst, "\\u00", 4);
+            dst[4] = hex[byte >> 4];
+            dst[5] = hex[byte & 0xF];
+        }
+    }
+    append((const uint8_t *)run_start, c - run_start);
+}
+
+void AIPayloadWriter::append_json_string(const String &p_text) {
+    append("\"");
+    append_json_escaped(p_text);
+    append("\"");
+}
+
+void AIPayloadWriter::append_json_string(const char *p_utf8) {
+    append("\"");
+    append_json_escaped(p_utf8);
+    append("\"");
+}
+
+String AIPayloadWriter::to_string() const {
+    String text;
+    text.parse_utf8((const char *)data, used);
+    return text;
+}
+
+PackedByteArray AIPayloadWriter::to_byte_array() const {
+    PackedByteArray bytes;
+    bytes.resize(used);
+    if (used > 0) {
+        memcpy(bytes.ptrw(), data, used);
+    }
+    return bytes;
+}
+
+AIPayloadWriter::~AIPayloadWriter() {
+    if (data) {
+        memfree(data);
+    }
+}
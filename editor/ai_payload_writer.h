@@ -0,0 +1,63 @@
+#ifndef AI_PAYLOAD_WRITER_H
+#define AI_PAYLOAD_WRITER_H
+
+#include "core/string/ustring.h"
+#include "core/variant/variant.h"
+
+// Append-only UTF-8 buffer for building request bodies and prompt text.
+//
+// Text is encoded (and JSON-escaped when asked) straight into one buffer, so a request costs one
+// growing allocation instead of a Dictionary/Array tree, its stringified copy and the UTF-8 copy
+// made when sending. clear() keeps the capacity, so a writer reused across turns stops allocating
+// once it has grown to the size of a typical request.
+class AIPayloadWriter {
+    uint8_t *data = nullptr;
+    uint32_t used = 0;
+    uint32_t capacity = 0;
+    uint32_t growth_count = 0;
+
+    void _grow(uint32_t p_extra);
+    _FORCE_INLINE_ uint8_t *_extend(uint32_t p_extra) {
+        if (used + p_extra > capacity) {
+            _grow(p_extra);
+        }
+        uint8_t *dst = data + used;
+        used += p_extra;
+        return dst;
+    }
+    void _append_utf8(const char32_t *p_text, int p_length);
+    void _append_escaped(const char32_t *p_text, int p_length);
+
+public:
+    void reserve(uint32_t p_capacity);
+    void clear() { used = 0; }
+
+    void append(const char *p_ascii);
+    void append(const uint8_t *p_data, uint32_t p_length);
+    void append(const AIPayloadWriter &p_other) { append(p_other.data, p_other.used); }
+    void append(const String &p_text);
+    void append_int(int64_t p_value);
+    void append_float(double p_value, int p_decimals = -1);
+
+    // Escaped contents of a JSON string, without the quotes, so one string can be written in parts.
+    void append_json_escaped(const String &p_text);
+    void append_json_escaped(const char *p_utf8);
+    void append_json_string(const String &p_text);
+    void append_json_string(const char *p_utf8);
+
+    const uint8_t *ptr() const { return data; }
+    uint32_t size() const { return used; }
+    bool is_empty() const { return used == 0; }
+    // Times the buffer had to be reallocated since it was created.
+    uint32_t get_growth_count() const { return growth_count; }
+
+    String to_string() const;
+    PackedByteArray to_byte_array() const;
+
+    AIPayloadWriter() {}
+    AIPayloadWriter(const AIPayloadWriter &) = delete;
+    AIPayloadWriter &operator=(const AIPayloadWriter &) = delete;
+    ~AIPayloadWriter();
+};
+
+#endif // AI_PAYLOAD_WRITER_H
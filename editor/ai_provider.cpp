@@ -0,0 +1,90 @@
+#include "ai_provider.h"
+
+void AIProvider::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("set_endpoint", "endpoint"), &AIProvider::set_endpoint);
+    ClassDB::bind_method(D_METHOD("get_endpoint"), &AIProvider::get_endpoint);
+    ClassDB::bind_method(D_METHOD("set_api_key", "api_key"), &AIProvider::set_api_key);
+    ClassDB::bind_method(D_METHOD("get_api_key"), &AIProvider::get_api_key);
+    ClassDB::bind_method(D_METHOD("set_model", "model"), &AIProvider::set_model);
+    ClassDB::bind_method(D_METHOD("get_model"), &AIProvider::get_model);
+    ClassDB::bind_method(D_METHOD("set_compress_requests", "enabled"), &AIProvider::set_compress_requests);
+    ClassDB::bind_method(D_METHOD("is_compressing_requests"), &AIProvider::is_compressing_requests);
+
+    ADD_PROPERTY(PropertyInfo(Variant::STRING, "endpoint"), "set_endpoint", "get_endpoint");
+    ADD_PROPERTY(PropertyInfo(Variant::STRING, "api_key"), "set_api_key", "get_api_key");
+    ADD_PROPERTY(PropertyInfo(Variant::STRING, "model"), "set_model", "get_model");
+    ADD_PROPERTY(PropertyInfo(Variant::BOOL, "compress_requests"), "set_compress_requests", "is_compressing_requests");
+
+    GDVIRTUAL_BIND(_complete, "body");
+}
+
+void AIProvider::set_endpoint(const String &p_endpoint) {
+    endpoint = p_endpoint;
+}
+
+String AIProvider::get_endpoint() const {
+    return endpoint;
+}
+
+void AIProvider::set_api_key(const String &p_api_key) {
+    api_key = p_api_key;
+}
+
+String AIProvider::get_api_key() const {
+    return api_key;
+}
+
+void AIProvider::set_model(const String &p_model) {
+    model = p_model;
+}
+
+String AIProvider::get_model() const {
+    return model;
+}
+
+void AIProvider::set_compress_requests(bool p_enabled) {
+    compress_requests = p_enabled;
+}
+
+bool AIProvider::is_compressing_requests() const {
+    return compress_requests;
+}
+
+Vector<String> AIProvider::get_headers() const {
+    Vector<String> headers;
+    headers.push_back("Content-Type: application/json");
+    if (!api_key.is_empty()) {
+        headers.push_back("Authorization: Bearer " + api_key);
+    }
+    return headers;
+}
+
+bool AIProvider::is_local() const {
+    if (has_in_process_completion()) {
+        return true;
+    }
+    // "scheme://host[:port]/path"
+    String authority = endpoint.get_slicec('/', 2);
+    if (authority.begins_with("[::1]")) {
+        return true;
+    }
+    String host = authority.get_slicec(':', 0);
+    return host == "localhost" || host == "127.0.0.1";
+}
+
+bool AIProvider::is_configured() const {
+    if (has_in_process_completion()) {
+        return true;
+    }
+    return !endpoint.is_empty() && (!api_key.is_empty() || is_local());
+}
+
+bool AIProvider::has_in_process_completion() const {
+    return GDVIRTUAL_IS_OVERRIDDEN(_complete);
+}
+
+String AIProvider::complete(const String &p_body) {
+    String response;
+    GDVIRTUAL_CALL(_complete, p_body, response);
+    return response;
+}
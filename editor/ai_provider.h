@@ -0,0 +1,46 @@
+#ifndef AI_PROVIDER_H
+#define AI_PROVIDER_H
+
+#include "core/object/gdvirtual.gen.inc"
+#include "core/object/ref_counted.h"
+
+// Where AIBackend sends a chat completion: any OpenAI-compatible endpoint (the OpenAI API, a local
+// llama.cpp style server, ...) with its key and model.
+//
+// Scripts and GDExtensions can override _complete() to answer requests in-process instead, e.g.
+// with a small quantized model on the CPU. It receives the same JSON request body that would be
+// posted and must return an OpenAI-style response body. It is called on a worker thread.
+class AIProvider : public RefCounted {
+    GDCLASS(AIProvider, RefCounted);
+
+    String endpoint;
+    String api_key;
+    String model;
+    bool compress_requests = false;
+
+protected:
+    static void _bind_methods();
+
+    GDVIRTUAL1R(String, _complete, String)
+
+public:
+    void set_endpoint(const String &p_endpoint);
+    String get_endpoint() const;
+    void set_api_key(const String &p_api_key);
+    String get_api_key() const;
+    void set_model(const String &p_model);
+    String get_model() const;
+    // Only for endpoints known to accept "Content-Encoding: gzip" request bodies.
+    void set_compress_requests(bool p_enabled);
+    bool is_compressing_requests() const;
+
+    Vector<String> get_headers() const;
+    // Local servers and in-process models work without an API key.
+    bool is_local() const;
+    bool is_configured() const;
+
+    bool has_in_process_completion() const;
+    String complete(const String &p_body);
+};
+
+#endif // AI_PROVIDER_H
@@ -0,0 +1,194 @@
+#include "ai_trace.h"
+
+#include "core/io/file_access.h"
+#include "core/io/json.h"
+#include "core/math/math_funcs.h"
+#include "core/os/thread.h"
+#include "editor/editor_settings.h"
+
+AITrace::Event AITrace::events[RING_SIZE];
+SafeNumeric<uint64_t> AITrace::event_count;
+SafeNumeric<uint64_t> AITrace::histograms[SPAN_MAX][HISTOGRAM_BUCKETS];
+SafeNumeric<uint64_t> AITrace::span_totals_usec[SPAN_MAX];
+SafeNumeric<uint64_t> AITrace::cache_hits[CACHE_MAX];
+SafeNumeric<uint64_t> AITrace::cache_misses[CACHE_MAX];
+
+const char *AITrace::get_span_name(Span p_span) {
+    static const char *names[SPAN_MAX] = {
+        "relevance",
+        "retrieval",
+        "embedding",
+        "prompt_build",
+        "network",
+        "first_token",
+        "render",
+        "turn",
+    };
+    return names[p_span];
+}
+
+const char *AITrace::get_cache_name(Cache p_cache) {
+    static const char *names[CACHE_MAX] = {
+        "request_coalescing",
+        "retrieval",
+    };
+    return names[p_cache];
+}
+
+int AITrace::_get_bucket(uint64_t p_usec) {
+    if (p_usec < 2) {
+        return int(p_usec);
+    }
+    // Two buckets per power of two, split on the bit below the most significant one.
+    int msb = 63;
+    while (!(p_usec & (uint64_t(1) << msb))) {
+        msb--;
+    }
+    return MIN(HISTOGRAM_BUCKETS - 1, 2 * msb + int((p_usec >> (msb - 1)) & 1));
+}
+
+uint64_t AITrace::_get_bucket_upper_bound(int p_bucket) {
+    if (p_bucket < 2) {
+        return p_bucket + 1;
+    }
+    int msb = p_bucket / 2;
+    uint64_t half = uint64_t(1) << (msb - 1);
+    return (uint64_t(1) << msb) + (p_bucket & 1) * half + half;
+}
+
+void AITrace::record(Span p_span, uint64_t p_start_usec, uint64_t p_end_usec) {
+    ERR_FAIL_INDEX(p_span, SPAN_MAX);
+    uint64_t duration = p_end_usec > p_start_usec ? p_end_usec - p_start_usec : 0;
+
+    histograms[p_span][_get_bucket(duration)].increment();
+    span_totals_usec[p_span].add(duration);
+
+    uint64_t index = event_count.postincrement();
+    Event &event = events[index % RING_SIZE];
+    event.sequence.set(0); // Mark the slot as being written.
+    event.span = p_span;
+    event.start_usec = p_start_usec;
+    event.duration_usec = duration;
+    event.thread_id = Thread::get_caller_id();
+    event.sequence.set(index + 1);
+}
+
+void AITrace::record_cache(Cache p_cache, bool p_hit) {
+    ERR_FAIL_INDEX(p_cache, CACHE_MAX);
+    if (p_hit) {
+        cache_hits[p_cache].increment();
+    } else {
+        cache_misses[p_cache].increment();
+    }
+}
+
+Dictionary AITrace::get_summary() {
+    Dictionary spans;
+    for (int i = 0; i < SPAN_MAX; i++) {
+        uint64_t counts[HISTOGRAM_BUCKETS];
+        uint64_t total = 0;
+        for (int j = 0; j < HISTOGRAM_BUCKETS; j++) {
+            counts[j] = histograms[i][j].get();
+            total += counts[j];
+        }
+
+        Dictionary span;
+        span["count"] = total;
+        span["mean_usec"] = total > 0 ? span_totals_usec[i].get() / total : 0;
+
+        // Percentiles are reported as the upper edge of the bucket they fall in.
+        const double percentiles[] = { 0.5, 0.9, 0.99, 1.0 };
+        const char *keys[] = { "p50_usec", "p90_usec", "p99_usec", "max_usec" };
+        for (int p = 0; p < 4; p++) {
+            uint64_t rank = uint64_t(Math::ceil(total * percentiles[p]));
+            uint64_t seen = 0;
+            uint64_t value = 0;
+            for (int j = 0; j < HISTOGRAM_BUCKETS && total > 0; j++) {
+                seen += counts[j];
+                if (seen >= rank && counts[j] > 0) {
+                    value = _get_bucket_upper_bound(j);
+                    break;
+                }
+            }
+            span[keys[p]] = value;
+        }
+        spans[get_span_name(Span(i))] = span;
+    }
+
+    Dictionary caches;
+    for (int i = 0; i < CACHE_MAX; i++) {
+        uint64_t hits = cache_hits[i].get();
+        uint64_t misses = cache_misses[i].get();
+        Dictionary cache;
+        cache["hits"] = hits;
+        cache["misses"] = misses;
+        cache["hit_rate"] = hits + misses > 0 ? double(hits) / (hits + misses) : 0.0;
+        caches[get_cache_name(Cache(i))] = cache;
+    }
+
+    Dictionary summary;
+    summary["spans"] = spans;
+    summary["caches"] = caches;
+    return summary;
+}
+
+Error AITrace::export_chrome_trace(const String &p_path) {
+    uint64_t count = event_count.get();
+    uint64_t first = count > RING_SIZE ? count - RING_SIZE : 0;
+
+    Array trace_events;
+    for (uint64_t index = first; index < count; index++) {
+        Event &event = events[index % RING_SIZE];
+        uint64_t sequence = event.sequence.get();
+        if (sequence != index + 1) {
+            continue;
+        }
+        Dictionary trace_event;
+        trace_event["name"] = get_span_name(Span(event.span));
+        trace_event["cat"] = "ai";
+        trace_event["ph"] = "X";
+        trace_event["ts"] = event.start_usec;
+        trace_event["dur"] = event.duration_usec;
+        trace_event["pid"] = 1;
+        trace_event["tid"] = event.thread_id;
+        if (event.sequence.get() != sequence) {
+            continue; // Overwritten while being copied.
+        }
+        trace_events.push_back(trace_event);
+    }
+
+    Dictionary trace;
+    trace["traceEvents"] = trace_events;
+    trace["displayTimeUnit"] = "ms";
+
+    Error err;
+    Ref<FileAccess> f = FileAccess::open(p_path, FileAccess::WRITE, &err);
+    ERR_FAIL_COND_V_MSG(f.is_null(), err, "Cannot write AI trace: " + p_path);
+    f->store_string(JSON::stringify(trace));
+    return OK;
+}
+
+void AITrace::reset() {
+    for (int i = 0; i < SPAN_MAX; i++) {
+        for (int j = 0; j < HISTOGRAM_BUCKETS; j++) {
+            histograms[i][j].set(0);
+        }
+        span_totals_usec[i].set(0);
+    }
+    for (int i = 0; i < CACHE_MAX; i++) {
+        cache_hits[i].set(0);
+        cache_misses[i].set(0);
+    }
+    for (int i = 0; i < RING_SIZE; i++) {
+        events[i].sequence.set(0);
+    }
+    event_count.set(0);
+}
+
+bool AITrace::is_verbose_logging() {
+    if (!EditorSettings::get_singleton()) {
+        return false;
+    }
+    Variant verbose_setting = EditorSettings::get_singleton()->get_setting("interface/ai/verbose_logging");
+    return verbose_setting.get_type() != Variant::NIL && bool(verbose_setting);
+}
@@ -0,0 +1,84 @@
+#ifndef AI_TRACE_H
+#define AI_TRACE_H
+
+#include "core/os/os.h"
+#include "core/templates/safe_refcount.h"
+#include "core/variant/dictionary.h"
+
+// Span timings and cache counters for the AI assistant pipeline.
+//
+// Recording is lock-free so it is safe from the HTTP and retriever threads: spans go into a fixed
+// ring buffer (kept for the Chrome trace export) and into per-span latency histograms with
+// half-octave buckets (used for percentiles). Readers may see a span that is being overwritten;
+// those are detected with a per-slot sequence number and skipped.
+class AITrace {
+public:
+    enum Span {
+        SPAN_RELEVANCE,
+        SPAN_RETRIEVAL,
+        SPAN_EMBEDDING,
+        SPAN_PROMPT_BUILD,
+        SPAN_NETWORK,
+        SPAN_FIRST_TOKEN,
+        SPAN_RENDER,
+        SPAN_TURN,
+        SPAN_MAX,
+    };
+
+    enum Cache {
+        CACHE_REQUEST_COALESCING,
+        CACHE_RETRIEVAL,
+        CACHE_MAX,
+    };
+
+private:
+    enum {
+        RING_SIZE = 4096,
+        HISTOGRAM_BUCKETS = 80,
+    };
+
+    struct Event {
+        SafeNumeric<uint64_t> sequence;
+        uint64_t start_usec = 0;
+        uint64_t duration_usec = 0;
+        uint64_t thread_id = 0;
+        int span = 0;
+    };
+
+    static Event events[RING_SIZE];
+    static SafeNumeric<uint64_t> event_count;
+    static SafeNumeric<uint64_t> histograms[SPAN_MAX][HISTOGRAM_BUCKETS];
+    static SafeNumeric<uint64_t> span_totals_usec[SPAN_MAX];
+    static SafeNumeric<uint64_t> cache_hits[CACHE_MAX];
+    static SafeNumeric<uint64_t> cache_misses[CACHE_MAX];
+
+    static int _get_bucket(uint64_t p_usec);
+    static uint64_t _get_bucket_upper_bound(int p_bucket);
+
+public:
+    static const char *get_span_name(Span p_span);
+    static const char *get_cache_name(Cache p_cache);
+
+    static uint64_t now() { return OS::get_singleton()->get_ticks_usec(); }
+    static void record(Span p_span, uint64_t p_start_usec, uint64_t p_end_usec);
+    static void record_cache(Cache p_cache, bool p_hit);
+
+    static Dictionary get_summary();
+    static Error export_chrome_trace(const String &p_path);
+    static void reset();
+
+    // Full prompts, script output and environment dumps are only logged when this is enabled.
+    static bool is_verbose_logging();
+};
+
+class AITraceScope {
+    AITrace::Span span;
+    uint64_t start_usec;
+
+public:
+    AITraceScope(AITrace::Span p_span) :
+            span(p_span), start_usec(AITrace::now()) {}
+    ~AITraceScope() { AITrace::record(span, start_usec, AITrace::now()); }
+};
+
+#endif // AI_TRACE_H
@@ -4,6 +4,12 @@
 #include "editor/themes/editor_scale.h"
 #include "editor/editor_string_names.h"
 #include "editor/editor_node.h"
+#include "editor/debugger/editor_debugger_node.h"
+#include "scene/gui/scroll_bar.h"
+#include "ai_metrics_panel.h"
+#include "ai_trace.h"
+
+static const char *RETRIEVAL_SNAPSHOT_FILE = "ai_chat_retrieval_cache.bin";
 
 void ChatDock::_notification(int p_what) {
     switch (p_what) {
@@ -23,15 +29,32 @@ void ChatDock::_notification(int p_what) {
                 input_field->grab_focus();
             }
             
-            // Initialize AI backend
-            ai_backend = Ref<AIBackend>(memnew(AIBackend));
-            Error err = ai_backend->initialize();
-            if (err != OK) {
-                chat_display->add_text("Error: Failed to initialize AI backend. Please check your settings.\n");
+            // Entered again whenever the dock is moved. The backend, its history and any turn in
+            // flight carry over, so they are only set up the first time.
+            if (ai_backend.is_null()) {
+                // Initialize AI backend
+                ai_backend = Ref<AIBackend>(memnew(AIBackend));
+                Error err = ai_backend->initialize();
+                if (err != OK) {
+                    transcript.add_message(ChatTranscript::ROLE_SYSTEM, "Error: Failed to initialize AI backend. Please check your settings.");
+                }
+
+                // Initialize docs retriever
+                _initialize_docs_retriever();
+
+                _restore_session();
             }
 
-            // Initialize docs retriever
-            _initialize_docs_retriever();
+            if (EditorDebuggerNode::get_singleton()) {
+                AIMetricsPanel::install();
+            }
+        } break;
+
+        case NOTIFICATION_EXIT_TREE: {
+            // Cached retrievals are kept for the next editor session.
+            if (docs_retriever.is_valid()) {
+                docs_retriever->save_snapshot_in_project(RETRIEVAL_SNAPSHOT_FILE);
+            }
         } break;
     }
 }
@@ -40,85 +63,146 @@ void ChatDock::_bind_methods() {
     ClassDB::bind_method(D_METHOD("_send_message"), &ChatDock::_send_message);
     ClassDB::bind_method(D_METHOD("_on_input_text_changed", "text"), &ChatDock::_on_input_text_changed);
     ClassDB::bind_method(D_METHOD("_on_input_text_submitted", "text"), &ChatDock::_on_input_text_submitted);
-    ClassDB::bind_method(D_METHOD("_on_ai_response", "response"), &ChatDock::_on_ai_response);
-    ClassDB::bind_method(D_METHOD("_on_relevance_response", "is_relevant"), &ChatDock::_on_relevance_response);
+    ClassDB::bind_method(D_METHOD("_on_ai_response", "response", "turn_start_usec"), &ChatDock::_on_ai_response);
+    ClassDB::bind_method(D_METHOD("_on_relevance_response", "is_relevant", "message", "turn_start_usec"), &ChatDock::_on_relevance_response);
+    ClassDB::bind_method(D_METHOD("submit_message", "message"), &ChatDock::submit_message);
+
+    ADD_SIGNAL(MethodInfo("turn_finished"));
 }
 
 void ChatDock::_initialize_docs_retriever() {
     docs_retriever = Ref<GodotDocsRetrieverBind>(memnew(GodotDocsRetrieverBind));
     Error err = docs_retriever->initialize();
     if (err != OK) {
-        chat_display->add_text("Warning: Failed to initialize documentation retriever. Documentation context will not be available.\n");
-    }
-}
-
-String ChatDock::_get_docs_context(const String &p_query) {
-    if (docs_retriever.is_valid()) {
-        Array results = docs_retriever->search(p_query);
-        if (results.size() > 0) {
-            String formatted_results = docs_retriever->format_results(results);
-            if (!formatted_results.is_empty()) {
-                ERR_PRINT("Formatted documentation results:\n" + formatted_results);
-                return formatted_results;
-            }
-        }
+        transcript.add_message(ChatTranscript::ROLE_SYSTEM, "Warning: Failed to initialize documentation retriever. Documentation context will not be available.");
+    } else {
+        // Answers the first questions of this session from the previous one's retrievals.
+        docs_retriever->load_snapshot_in_project(RETRIEVAL_SNAPSHOT_FILE);
     }
-    return String();
 }
 
 void ChatDock::_send_message() {
     String message = input_field->get_text().strip_edges();
     if (!message.is_empty()) {
-        chat_display->add_text("You: " + message + "\n");
+        uint64_t turn_start_usec = AITrace::now();
+        ChatTranscript::Handle user_message = transcript.add_message(ChatTranscript::ROLE_USER, message);
+        transcript.set_log_index(user_message, session_log.append(ChatTranscript::ROLE_USER, message));
         input_field->clear();
         
         if (ai_backend.is_valid()) {
-            chat_display->add_text("AI: Thinking...\n");
-            
-            // Store message for use in callback
-            pending_message = message;
+            pending_replies.push_back(transcript.add_message(ChatTranscript::ROLE_ASSISTANT, "Thinking...", true));
             
-            // Check if the message is relevant to Godot
-            ai_backend->check_godot_relevance(message, callable_mp(this, &ChatDock::_on_relevance_response));
+            // Check if the message is relevant to Godot. Input is never blocked, so the message
+            // travels with its own callback rather than in a field the next message would overwrite.
+            ai_backend->check_godot_relevance(message, callable_mp(this, &ChatDock::_on_relevance_response).bind(message, turn_start_usec));
         } else {
-            chat_display->add_text("AI: Error - AI backend not initialized.\n");
+            transcript.add_message(ChatTranscript::ROLE_ASSISTANT, "Error - AI backend not initialized.");
         }
     }
 }
 
-void ChatDock::_on_relevance_response(bool p_is_relevant) {
+void ChatDock::_on_relevance_response(bool p_is_relevant, const String &p_message, uint64_t p_turn_start_usec) {
+    AITrace::record(AITrace::SPAN_RELEVANCE, p_turn_start_usec, AITrace::now());
+
+    // The documentation is kept apart from the message so the backend can leave it out of the history.
+    // The parts are escaped straight into the request body, so nothing is concatenated here.
+    PackedStringArray context;
     // Get documentation context only if the message is relevant
-    String docs_context;
-    if (p_is_relevant) {
-        docs_context = _get_docs_context(pending_message);
+    if (p_is_relevant && docs_retriever.is_valid()) {
+        PackedStringArray docs_context;
+        docs_retriever->append_docs_context(p_message, docs_context);
+        if (!docs_context.is_empty()) {
+            context.push_back("Relevant Godot Documentation:\n");
+            context.append_array(docs_context);
+            context.push_back("\nPlease use the above documentation context to help answer this question.\n\n");
+        }
     }
-    
-    // Combine user message with documentation context if relevant
-    String enhanced_message;
-    if (p_is_relevant && !docs_context.is_empty()) {
-        enhanced_message = "User Query: " + pending_message + "\n\n";
-        enhanced_message += "Relevant Godot Documentation:\n" + docs_context + "\n\n";
-        enhanced_message += "Please use the above documentation context to help answer this question: " + pending_message;
-    } else {
-        enhanced_message = pending_message;
+
+    uint64_t prompt_start = AITrace::now();
+
+    // Only what changed in the editor since the previous message is sent, so it stays in the
+    // history with the message for later deltas to build on.
+    PackedStringArray history_context;
+    if (AIEditorContext::is_enabled()) {
+        editor_context->start();
+        String context_summary = editor_context->take_context();
+        if (!context_summary.is_empty()) {
+            history_context.push_back("Editor Context:\n");
+            history_context.push_back(context_summary);
+            history_context.push_back("\n");
+        }
     }
     
-    // Log the enhanced message being sent to the LLM
-    ERR_PRINT("Sending to LLM (ChatDock):\n" + enhanced_message);
+    AITrace::record(AITrace::SPAN_PROMPT_BUILD, prompt_start, AITrace::now());
+
+    // Full prompts are only logged on request, they can be very large
+    if (AITrace::is_verbose_logging()) {
+        print_line("Sending to LLM (ChatDock):\n" + String().join(history_context) + String().join(context) + p_message);
+    }
     
-    ai_backend->send_message(enhanced_message, callable_mp(this, &ChatDock::_on_ai_response));
+    ai_backend->send_message(p_message, callable_mp(this, &ChatDock::_on_ai_response).bind(p_turn_start_usec), context, history_context);
 }
 
-void ChatDock::_on_ai_response(const String &p_response) {
-    // Remove only the last line containing "Thinking..."
-    String current_text = chat_display->get_text();
-    int thinking_pos = current_text.rfind("AI: Thinking...\n");
-    if (thinking_pos != -1) {
-        chat_display->remove_paragraph(chat_display->get_paragraph_count() - 2);
+void ChatDock::_on_ai_response(const String &p_response, uint64_t p_turn_start_usec) {
+    AITrace::record(AITrace::SPAN_FIRST_TOKEN, p_turn_start_usec, AITrace::now());
+
+    // A failed turn has already been reported by the backend; it is not logged as a reply.
+    String text = p_response;
+    int64_t log_index = -1;
+    if (p_response.is_empty()) {
+        text = "Error - No reply was received from the AI provider.";
+        // The failed turn's editor changes never made it into the history, so the next turn
+        // describes the editor in full.
+        editor_context->reset_sent();
+    } else {
+        log_index = session_log.append(ChatTranscript::ROLE_ASSISTANT, p_response);
     }
-    
-    // Add the actual response
-    chat_display->add_text("AI: " + p_response + "\n");
+
+    // Swap the "Thinking..." placeholder for the reply without touching the rest of the transcript
+    {
+        AITraceScope trace_scope(AITrace::SPAN_RENDER);
+        if (!pending_replies.is_empty()) {
+            ChatTranscript::Handle reply = pending_replies.front()->get();
+            pending_replies.pop_front();
+            // Indexed first, since a replaced message can be evicted right away.
+            transcript.set_log_index(reply, log_index);
+            transcript.replace_message(reply, text);
+        } else {
+            transcript.set_log_index(transcript.add_message(ChatTranscript::ROLE_ASSISTANT, text), log_index);
+        }
+    }
+
+    AITrace::record(AITrace::SPAN_TURN, p_turn_start_usec, AITrace::now());
+    emit_signal(SNAME("turn_finished"));
+}
+
+void ChatDock::_on_scroll_changed(double p_value) {
+    // Messages outside the label's window are only put back once the user scrolls to them.
+    transcript.scrolled(session_log, 20);
+}
+
+void ChatDock::_restore_session() {
+    if (session_log.open_in_project("ai_chat_session.log") != OK) {
+        return;
+    }
+
+    Vector<ChatSessionLog::Entry> entries = transcript.restore_tail(session_log, 50);
+    Vector<AIBackend::HistoryMessage> history;
+    for (const ChatSessionLog::Entry &entry : entries) {
+        if (entry.role == ChatTranscript::ROLE_USER) {
+            history.push_back({ "user", entry.text });
+        } else if (entry.role == ChatTranscript::ROLE_ASSISTANT) {
+            history.push_back({ "assistant", entry.text });
+        }
+    }
+    if (ai_backend.is_valid()) {
+        ai_backend->restore_history(history);
+    }
+}
+
+void ChatDock::submit_message(const String &p_message) {
+    input_field->set_text(p_message);
+    _send_message();
 }
 
 void ChatDock::_on_input_text_changed(const String &p_text) {
@@ -144,6 +228,8 @@ ChatDock::ChatDock() {
     chat_display->set_custom_minimum_size(Size2(0, 100) * EDSCALE);
     chat_display->set_h_size_flags(SIZE_EXPAND_FILL);
     add_child(chat_display);
+    chat_display->get_v_scroll_bar()->connect("value_changed", callable_mp(this, &ChatDock::_on_scroll_changed));
+    transcript.set_display(chat_display);
 
     // Input area container
     HBoxContainer *input_hbox = memnew(HBoxContainer);
@@ -165,8 +251,11 @@ ChatDock::ChatDock() {
     send_button->connect("pressed", callable_mp(this, &ChatDock::_send_message));
     input_hbox->add_child(send_button);
 
+    // Scene, selection and script summaries, kept up to date from editor signals
+    editor_context = Ref<AIEditorContext>(memnew(AIEditorContext));
+
     // Initial welcome message
-    chat_display->add_text("Welcome to the Godot AI Assistant! How can I help you today?\n");
+    transcript.add_message(ChatTranscript::ROLE_SYSTEM, "Welcome to the Godot AI Assistant! How can I help you today?");
 }
 
 ChatDock::~ChatDock() {
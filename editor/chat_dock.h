@@ -6,7 +6,10 @@
 #include "scene/gui/rich_text_label.h"
 #include "scene/gui/button.h"
 #include "ai_backend.h"
+#include "ai_editor_context.h"
 #include "godot_docs_retriever_bind.h"
+#include "chat_session_log.h"
+#include "chat_transcript.h"
 
 class ChatDock : public VBoxContainer {
     GDCLASS(ChatDock, VBoxContainer);
@@ -17,21 +20,29 @@ private:
     Button *send_button = nullptr;
     Ref<AIBackend> ai_backend;
     Ref<GodotDocsRetrieverBind> docs_retriever;
-    String pending_message;
+    Ref<AIEditorContext> editor_context;
+    ChatTranscript transcript;
+    // "Thinking..." placeholders of the turns in flight, oldest first. The backend answers a
+    // dock's turns in the order they were sent.
+    List<ChatTranscript::Handle> pending_replies;
+    ChatSessionLog session_log;
 
     void _send_message();
     void _on_input_text_changed(const String &p_text);
     void _on_input_text_submitted(const String &p_text);
-    void _on_ai_response(const String &p_response);
-    void _on_relevance_response(bool p_is_relevant);
-    String _get_docs_context(const String &p_query);
+    void _on_ai_response(const String &p_response, uint64_t p_turn_start_usec);
+    void _on_relevance_response(bool p_is_relevant, const String &p_message, uint64_t p_turn_start_usec);
     void _initialize_docs_retriever();
+    void _on_scroll_changed(double p_value);
+    void _restore_session();
 
 protected:
     void _notification(int p_what);
     static void _bind_methods();
 
 public:
+    void submit_message(const String &p_message);
+
     ChatDock();
     ~ChatDock();
 };
@@ -0,0 +1,250 @@
+#include "chat_session_log.h"
+
+#include "core/io/compression.h"
+#include "core/io/marshalls.h"
+#include "core/os/os.h"
+#include "editor/editor_paths.h"
+
+static const uint32_t SESSION_LOG_MAGIC = 0x53434447; // "GDCS"
+static const uint32_t SESSION_LOG_VERSION = 1;
+static const uint32_t SESSION_LOG_HEADER_SIZE = 8;
+static const uint32_t FRAME_HEADER_SIZE = 12;
+// How long the writer waits for more messages before compressing a frame.
+static const uint32_t FLUSH_DELAY_USEC = 250000;
+// The wait is sliced so close() does not have to sit it out.
+static const uint32_t FLUSH_POLL_USEC = 10000;
+
+Error ChatSessionLog::open(const String &p_path) {
+    close();
+
+    path = p_path;
+    frames.clear();
+    queue.clear();
+    entry_count = 0;
+    write_offset = 0;
+    exit_thread.clear();
+
+    Ref<FileAccess> f = FileAccess::open(path, FileAccess::READ);
+    if (f.is_valid()) {
+        if (f->get_32() != SESSION_LOG_MAGIC || f->get_32() != SESSION_LOG_VERSION) {
+            ERR_PRINT("Ignoring chat session log with unknown format: " + path);
+        } else {
+            // Only the frame headers are read here; payloads are skipped with a seek.
+            uint64_t length = f->get_length();
+            uint64_t offset = SESSION_LOG_HEADER_SIZE;
+            while (offset + FRAME_HEADER_SIZE <= length) {
+                f->seek(offset);
+                Frame frame;
+                frame.offset = offset;
+                frame.first_entry = entry_count;
+                frame.entry_count = f->get_32();
+                frame.raw_size = f->get_32();
+                frame.compressed_size = f->get_32();
+                if (offset + FRAME_HEADER_SIZE + frame.compressed_size > length) {
+                    break; // Torn write from a crash; the next frame overwrites it.
+                }
+                frames.push_back(frame);
+                entry_count += frame.entry_count;
+                offset += FRAME_HEADER_SIZE + frame.compressed_size;
+            }
+            write_offset = offset;
+        }
+    }
+
+    thread.start(_thread_func, this);
+    return OK;
+}
+
+Error ChatSessionLog::open_in_project(const String &p_file) {
+    if (!EditorPaths::get_singleton()) {
+        return ERR_UNAVAILABLE;
+    }
+    return open(EditorPaths::get_singleton()->get_project_settings_dir().path_join(p_file));
+}
+
+void ChatSessionLog::close() {
+    if (!thread.is_started()) {
+        return;
+    }
+    exit_thread.set();
+    semaphore.post();
+    thread.wait_to_finish();
+    write_file.unref();
+}
+
+int64_t ChatSessionLog::append(int p_role, const String &p_text) {
+    if (!thread.is_started()) {
+        return -1;
+    }
+
+    Entry entry;
+    entry.role = p_role;
+    entry.text = p_text;
+
+    MutexLock lock(mutex);
+    entry.index = entry_count++;
+    queue.push_back(entry);
+    semaphore.post();
+    return entry.index;
+}
+
+void ChatSessionLog::_thread_func(void *p_userdata) {
+    ChatSessionLog *log = (ChatSessionLog *)p_userdata;
+    while (true) {
+        log->semaphore.wait();
+        if (!log->exit_thread.is_set()) {
+            MutexLock lock(log->mutex);
+            if (log->queue.is_empty()) {
+                continue; // Posted for a message that an earlier batch already took.
+            }
+        }
+
+        // Let a burst of messages pile up so they share one compressed frame.
+        uint64_t flush_usec = OS::get_singleton()->get_ticks_usec() + FLUSH_DELAY_USEC;
+        while (!log->exit_thread.is_set() && OS::get_singleton()->get_ticks_usec() < flush_usec) {
+            OS::get_singleton()->delay_usec(FLUSH_POLL_USEC);
+        }
+        // The batch taken below holds every message posted so far, so their posts must not
+        // wake the thread again.
+        while (log->semaphore.try_wait()) {
+        }
+        bool exiting = log->exit_thread.is_set();
+
+        Vector<Entry> batch;
+        {
+            MutexLock lock(log->mutex);
+            batch = log->queue;
+        }
+        if (!batch.is_empty()) {
+            Frame frame;
+            bool written = log->_write_frame(batch, frame);
+            MutexLock lock(log->mutex);
+            log->queue = log->queue.slice(batch.size());
+            if (written) {
+                log->frames.push_back(frame);
+            }
+        }
+
+        if (exiting) {
+            break;
+        }
+    }
+}
+
+bool ChatSessionLog::_write_frame(const Vector<Entry> &p_entries, Frame &r_frame) {
+    if (write_file.is_null()) {
+        if (write_offset == 0) {
+            write_file = FileAccess::open(path, FileAccess::WRITE);
+            ERR_FAIL_COND_V_MSG(write_file.is_null(), false, "Cannot create chat session log: " + path);
+            write_file->store_32(SESSION_LOG_MAGIC);
+            write_file->store_32(SESSION_LOG_VERSION);
+            write_offset = SESSION_LOG_HEADER_SIZE;
+        } else {
+            write_file = FileAccess::open(path, FileAccess::READ_WRITE);
+            ERR_FAIL_COND_V_MSG(write_file.is_null(), false, "Cannot open chat session log: " + path);
+        }
+    }
+
+    // Each entry is stored as [role:u8][length:u32][utf8 bytes].
+    Vector<uint8_t> raw;
+    for (const Entry &entry : p_entries) {
+        CharString utf8 = entry.text.utf8();
+        int pos = raw.size();
+        raw.resize(pos + 5 + utf8.length());
+        uint8_t *w = raw.ptrw() + pos;
+        w[0] = uint8_t(entry.role);
+        encode_uint32(utf8.length(), w + 1);
+        memcpy(w + 5, utf8.get_data(), utf8.length());
+    }
+
+    Vector<uint8_t> compressed;
+    compressed.resize(Compression::get_max_compressed_buffer_size(raw.size(), Compression::MODE_ZSTD));
+    int compressed_size = Compression::compress(compressed.ptrw(), raw.ptr(), raw.size(), Compression::MODE_ZSTD);
+    ERR_FAIL_COND_V(compressed_size < 0, false);
+
+    r_frame.offset = write_offset;
+    r_frame.first_entry = p_entries[0].index;
+    r_frame.entry_count = p_entries.size();
+    r_frame.raw_size = raw.size();
+    r_frame.compressed_size = compressed_size;
+
+    write_file->seek(write_offset);
+    write_file->store_32(r_frame.entry_count);
+    write_file->store_32(r_frame.raw_size);
+    write_file->store_32(r_frame.compressed_size);
+    write_file->store_buffer(compressed.ptr(), compressed_size);
+    write_file->flush();
+    write_offset += FRAME_HEADER_SIZE + compressed_size;
+    return true;
+}
+
+Vector<ChatSessionLog::Entry> ChatSessionLog::_read_frames(const Vector<Frame> &p_frames, int64_t p_from, int64_t p_to) {
+    Vector<Entry> entries;
+    if (p_frames.is_empty()) {
+        return entries;
+    }
+    Ref<FileAccess> f = FileAccess::open(path, FileAccess::READ);
+    ERR_FAIL_COND_V_MSG(f.is_null(), entries, "Cannot read chat session log: " + path);
+
+    Vector<uint8_t> compressed;
+    Vector<uint8_t> raw;
+    for (const Frame &frame : p_frames) {
+        compressed.resize(frame.compressed_size);
+        raw.resize(frame.raw_size);
+        f->seek(frame.offset + FRAME_HEADER_SIZE);
+        f->get_buffer(compressed.ptrw(), frame.compressed_size);
+        int raw_size = Compression::decompress(raw.ptrw(), frame.raw_size, compressed.ptr(), frame.compressed_size, Compression::MODE_ZSTD);
+        ERR_CONTINUE_MSG(raw_size != int(frame.raw_size), "Corrupted frame in chat session log: " + path);
+
+        const uint8_t *r = raw.ptr();
+        int pos = 0;
+        for (uint32_t j = 0; j < frame.entry_count && pos + 5 <= raw_size; j++) {
+            Entry entry;
+            entry.role = r[pos];
+            entry.index = frame.first_entry + j;
+            uint32_t length = decode_uint32(r + pos + 1);
+            pos += 5;
+            ERR_BREAK(pos + int(length) > raw_size);
+            // Frames are whole batches, so only the requested part of the edge frames is kept.
+            if (entry.index >= p_from && entry.index < p_to) {
+                entry.text.parse_utf8((const char *)r + pos, length);
+                entries.push_back(entry);
+            }
+            pos += length;
+        }
+    }
+    return entries;
+}
+
+Vector<ChatSessionLog::Entry> ChatSessionLog::load_before(int64_t p_index, int p_count) {
+    int64_t from = MAX(int64_t(0), p_index - p_count);
+    Vector<Frame> overlapping;
+    Vector<Entry> queued;
+    {
+        MutexLock lock(mutex);
+        for (const Frame &frame : frames) {
+            if (frame.first_entry < p_index && frame.first_entry + frame.entry_count > from) {
+                overlapping.push_back(frame);
+            }
+        }
+        // Not written yet; these are always newer than every frame.
+        for (const Entry &entry : queue) {
+            if (entry.index >= from && entry.index < p_index) {
+                queued.push_back(entry);
+            }
+        }
+    }
+
+    Vector<Entry> entries = _read_frames(overlapping, from, p_index);
+    entries.append_array(queued);
+    return entries;
+}
+
+int64_t ChatSessionLog::get_entry_count() const {
+    MutexLock lock(mutex);
+    return entry_count;
+}
+
+ChatSessionLog::~ChatSessionLog() {
+    close();
+}
@@ -0,0 +1,69 @@
+#ifndef CHAT_SESSION_LOG_H
+#define CHAT_SESSION_LOG_H
+
+#include "core/io/file_access.h"
+#include "core/os/mutex.h"
+#include "core/os/semaphore.h"
+#include "core/os/thread.h"
+#include "core/templates/safe_refcount.h"
+#include "core/templates/vector.h"
+
+// Append-only, compressed log of a dock's conversation, stored per project.
+//
+// The file is a short header followed by frames, each holding a zstd-compressed batch of
+// messages. Opening only walks the frame headers; message text is decompressed on demand,
+// newest frames first. Writes are queued and batched into frames on a worker thread.
+// Messages are addressed by their index in the log, so a reader can page back from any message.
+class ChatSessionLog {
+public:
+    struct Entry {
+        int role = 0;
+        String text;
+        int64_t index = -1;
+    };
+
+private:
+    struct Frame {
+        uint64_t offset = 0;
+        int64_t first_entry = 0;
+        uint32_t entry_count = 0;
+        uint32_t raw_size = 0;
+        uint32_t compressed_size = 0;
+    };
+
+    String path;
+    Vector<Frame> frames;
+    // Appended so far, written or not.
+    int64_t entry_count = 0;
+    uint64_t write_offset = 0;
+
+    Ref<FileAccess> write_file;
+    // Messages leave the queue only once their frame is listed, so each one can always be read
+    // from one or the other.
+    Vector<Entry> queue;
+    Mutex mutex;
+    Semaphore semaphore;
+    Thread thread;
+    SafeFlag exit_thread;
+
+    static void _thread_func(void *p_userdata);
+    bool _write_frame(const Vector<Entry> &p_entries, Frame &r_frame);
+    Vector<Entry> _read_frames(const Vector<Frame> &p_frames, int64_t p_from, int64_t p_to);
+
+public:
+    Error open(const String &p_path);
+    // Opens the named log in the project's editor settings directory; fails when there is no
+    // editor, e.g. in headless benchmarks.
+    Error open_in_project(const String &p_file);
+    void close();
+
+    // Returns the message's index in the log, or -1 (doing nothing) while no log is open.
+    int64_t append(int p_role, const String &p_text);
+    // Up to p_count messages right before p_index, oldest first.
+    Vector<Entry> load_before(int64_t p_index, int p_count);
+    int64_t get_entry_count() const;
+
+    ~ChatSessionLog();
+};
+
+#endif // CHAT_SESSION_LOG_H
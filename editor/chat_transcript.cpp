@@ -0,0 +1,462 @@
+#include "chat_transcript.h"
+
+#include "scene/gui/rich_text_label.h"
+#include "scene/gui/scroll_bar.h"
+
+void ChatTranscript::set_display(RichTextLabel *p_display) {
+    display = p_display;
+    _rebuild();
+}
+
+void ChatTranscript::set_limits(int p_max_messages, int64_t p_max_length, int p_render_window) {
+    max_messages = MAX(1, p_max_messages);
+    max_length = MAX(1, p_max_length);
+    render_window = MAX(1, p_render_window);
+    _evict();
+}
+
+void ChatTranscript::_parse(Message &p_message, bool p_flush) {
+    // Only complete lines are split into blocks; a partial last line stays in `text` until more
+    // of the reply arrives (or the message is flushed), so streamed replies are parsed once.
+    const String &text = p_message.text;
+    int pos = p_message.parsed_length;
+    while (pos < text.length()) {
+        int eol = text.find_char('\n', pos);
+        if (eol == -1) {
+            if (!p_flush) {
+                break;
+            }
+            eol = text.length();
+        }
+        String line = text.substr(pos, eol - pos);
+        pos = MIN(eol + 1, text.length());
+
+        if (line.begins_with("```")) {
+            Block block;
+            block.code = !p_message.in_code;
+            if (block.code) {
+                block.language = line.substr(3).strip_edges();
+            }
+            p_message.in_code = block.code;
+            p_message.blocks.push_back(block);
+            continue;
+        }
+
+        if (!p_message.in_code && line.begins_with("#")) {
+            Block block;
+            block.heading = true;
+            block.text = line.lstrip("#").strip_edges();
+            p_message.blocks.push_back(block);
+            p_message.blocks.push_back(Block());
+            continue;
+        }
+
+        if (p_message.blocks.is_empty()) {
+            p_message.blocks.push_back(Block());
+        }
+        Block &block = p_message.blocks.write[p_message.blocks.size() - 1];
+        if (!block.text.is_empty()) {
+            block.text += "\n";
+        }
+        block.text += line;
+    }
+    p_message.parsed_length = pos;
+}
+
+void ChatTranscript::_render_block(const Block &p_block) {
+    if (p_block.code) {
+        // One line per push, with the newlines at the top level. remove_paragraph() only looks at
+        // top-level items, so a newline nested in a tag would take the whole block with it.
+        Vector<String> lines = p_block.text.split("\n");
+        for (int i = 0; i < lines.size(); i++) {
+            if (i > 0) {
+                display->add_text("\n");
+            }
+            display->push_mono();
+            display->push_bgcolor(Color(0, 0, 0, 0.25));
+            display->add_text(lines[i]);
+            display->pop();
+            display->pop();
+        }
+    } else if (p_block.heading) {
+        display->push_bold();
+        display->add_text(p_block.text);
+        display->pop();
+    } else {
+        display->add_text(p_block.text);
+    }
+}
+
+void ChatTranscript::_render(Message &p_message) {
+    p_message.paragraph_start = display->get_paragraph_count() - 1;
+
+    switch (p_message.role) {
+        case ROLE_USER: {
+            display->add_text("You: ");
+        } break;
+        case ROLE_ASSISTANT: {
+            display->add_text("AI: ");
+        } break;
+        default:
+            break;
+    }
+
+    bool first = true;
+    for (const Block &block : p_message.blocks) {
+        if (block.text.is_empty() && !block.code) {
+            continue;
+        }
+        if (!first) {
+            display->add_text("\n");
+        }
+        _render_block(block);
+        first = false;
+    }
+
+    // The unparsed tail of a reply that is still streaming in.
+    String tail = p_message.text.substr(p_message.parsed_length);
+    if (!tail.is_empty()) {
+        if (!first) {
+            display->add_text("\n");
+        }
+        display->add_text(tail);
+    }
+
+    display->add_text("\n");
+    p_message.paragraph_count = display->get_paragraph_count() - 1 - p_message.paragraph_start;
+}
+
+void ChatTranscript::_unrender_tail(Handle p_from) {
+    int start = p_from->get().paragraph_start;
+    int count = 0;
+    for (Handle E = p_from; E; E = E->next()) {
+        count += E->get().paragraph_count;
+        E->get().paragraph_start = -1;
+        E->get().paragraph_count = 0;
+        rendered_count--;
+        if (E == last_rendered) {
+            break;
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        display->remove_paragraph(start);
+    }
+    if (p_from == first_rendered) {
+        first_rendered = nullptr;
+        last_rendered = nullptr;
+    } else {
+        last_rendered = p_from->prev();
+    }
+}
+
+void ChatTranscript::_unrender_front() {
+    Message &message = first_rendered->get();
+    int count = message.paragraph_count;
+    for (int i = 0; i < count; i++) {
+        display->remove_paragraph(message.paragraph_start);
+    }
+    message.paragraph_start = -1;
+    message.paragraph_count = 0;
+    rendered_count--;
+
+    if (first_rendered == last_rendered) {
+        first_rendered = nullptr;
+        last_rendered = nullptr;
+        return;
+    }
+    first_rendered = first_rendered->next();
+    for (Handle E = first_rendered; E; E = E->next()) {
+        E->get().paragraph_start -= count;
+        if (E == last_rendered) {
+            break;
+        }
+    }
+}
+
+void ChatTranscript::_render_window(Handle p_first) {
+    // The label can only be appended to, so moving the window re-renders it, which costs at most
+    // render_window messages however long the session is.
+    for (Handle E = first_rendered; E; E = E->next()) {
+        E->get().paragraph_start = -1;
+        E->get().paragraph_count = 0;
+        if (E == last_rendered) {
+            break;
+        }
+    }
+    display->clear();
+    rendered_count = 0;
+    first_rendered = p_first;
+    last_rendered = nullptr;
+    for (Handle E = p_first; E && rendered_count < render_window; E = E->next()) {
+        _render(E->get());
+        rendered_count++;
+        last_rendered = E;
+    }
+    if (!last_rendered) {
+        first_rendered = nullptr;
+    }
+}
+
+void ChatTranscript::_show_tail() {
+    Handle E = messages.back();
+    for (int i = 1; i < render_window && E && E->prev(); i++) {
+        E = E->prev();
+    }
+    _render_window(E);
+}
+
+void ChatTranscript::_rebuild() {
+    if (!display) {
+        return;
+    }
+    if (first_rendered) {
+        _render_window(first_rendered);
+    } else {
+        _show_tail();
+    }
+}
+
+void ChatTranscript::_evict() {
+    // Replies still waiting for the backend are skipped so their handles stay valid.
+    Handle E = messages.front();
+    while (E && messages.size() > 1 && (messages.size() > max_messages || total_length > max_length)) {
+        Handle next = E->next();
+        if (!E->get().pending) {
+            if (E == first_rendered) {
+                _unrender_front();
+            } else if (E->get().paragraph_start != -1) {
+                break;
+            }
+            total_length -= E->get().text.length();
+            if (E->get().log_index >= 0) {
+                log_resume_index = MAX(log_resume_index, E->get().log_index + 1);
+            }
+            messages.erase(E);
+        }
+        E = next;
+    }
+    if (display && !first_rendered && !messages.is_empty()) {
+        // The whole window was evicted while older messages were shown.
+        _show_tail();
+    }
+}
+
+ChatTranscript::Handle ChatTranscript::add_message(Role p_role, const String &p_text, bool p_pending) {
+    Message message;
+    message.role = p_role;
+    message.text = p_text;
+    message.pending = p_pending;
+    _parse(message, !p_pending);
+
+    Handle handle = messages.push_back(message);
+    total_length += p_text.length();
+
+    if (display) {
+        if (last_rendered && last_rendered != handle->prev()) {
+            // Older messages are being shown; a new one brings the view back to the newest.
+            _show_tail();
+        } else {
+            _render(handle->get());
+            rendered_count++;
+            last_rendered = handle;
+            if (!first_rendered) {
+                first_rendered = handle;
+            }
+            while (rendered_count > render_window) {
+                _unrender_front();
+            }
+        }
+    }
+
+    _evict();
+    return handle;
+}
+
+void ChatTranscript::append_to_message(Handle p_handle, const String &p_chunk) {
+    ERR_FAIL_NULL(p_handle);
+    Message &message = p_handle->get();
+    message.text += p_chunk;
+    total_length += p_chunk.length();
+    _parse(message, !message.pending);
+
+    if (display && message.paragraph_start != -1) {
+        // Re-render from this message to the end of the window; for the usual case of the newest
+        // reply this only touches the reply itself.
+        Handle last = last_rendered;
+        _unrender_tail(p_handle);
+        if (!first_rendered) {
+            first_rendered = p_handle;
+        }
+        for (Handle E = p_handle; E; E = E->next()) {
+            _render(E->get());
+            rendered_count++;
+            last_rendered = E;
+            if (E == last) {
+                break;
+            }
+        }
+    }
+}
+
+void ChatTranscript::replace_message(Handle p_handle, const String &p_text, bool p_pending) {
+    ERR_FAIL_NULL(p_handle);
+    Message &message = p_handle->get();
+    total_length -= message.text.length();
+    message.text = String();
+    message.blocks.clear();
+    message.parsed_length = 0;
+    message.in_code = false;
+    message.pending = p_pending;
+
+    append_to_message(p_handle, p_text);
+    _evict();
+}
+
+ChatTranscript::Handle ChatTranscript::_get_page_anchor() const {
+    // Unlogged system messages at the front, such as the welcome, stay above the paged-in history.
+    Handle E = messages.front();
+    while (E && E->get().role == ROLE_SYSTEM && E->get().log_index < 0) {
+        E = E->next();
+    }
+    return E;
+}
+
+bool ChatTranscript::_is_pinned(Handle p_handle) const {
+    Handle anchor = _get_page_anchor();
+    for (Handle E = messages.front(); E && E != anchor; E = E->next()) {
+        if (E == p_handle) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ChatTranscript::prepend_message(Role p_role, const String &p_text, int64_t p_log_index) {
+    // Older history paged back in, below the pinned messages; it stays out of the label until
+    // the window reaches it.
+    Message message;
+    message.role = p_role;
+    message.text = p_text;
+    message.log_index = p_log_index;
+    _parse(message, true);
+    Handle anchor = _get_page_anchor();
+    if (anchor) {
+        messages.insert_before(anchor, message);
+    } else {
+        messages.push_back(message);
+    }
+    total_length += p_text.length();
+}
+
+void ChatTranscript::set_log_index(Handle p_handle, int64_t p_log_index) {
+    ERR_FAIL_NULL(p_handle);
+    p_handle->get().log_index = p_log_index;
+}
+
+bool ChatTranscript::has_older() const {
+    return first_rendered && first_rendered->prev();
+}
+
+void ChatTranscript::show_older(int p_count) {
+    if (!display || !has_older()) {
+        return;
+    }
+
+    // The window slides up, dropping as many messages at the bottom as it gains at the top.
+    Handle old_first = first_rendered;
+    Handle E = first_rendered;
+    for (int i = 0; i < MIN(p_count, render_window - 1) && E->prev(); i++) {
+        E = E->prev();
+    }
+    _render_window(E);
+
+    // Keep the message that used to be at the top in view.
+    if (old_first->get().paragraph_start != -1) {
+        display->scroll_to_paragraph(old_first->get().paragraph_start);
+    }
+}
+
+bool ChatTranscript::has_newer() const {
+    return last_rendered && last_rendered->next();
+}
+
+void ChatTranscript::show_newer(int p_count) {
+    if (!display || !has_newer()) {
+        return;
+    }
+
+    Handle old_last = last_rendered;
+    Handle E = first_rendered;
+    Handle last = last_rendered;
+    for (int i = 0; i < MIN(p_count, render_window - 1) && last->next(); i++) {
+        E = E->next();
+        last = last->next();
+    }
+    _render_window(E);
+
+    // Keep the message that used to be at the bottom in view.
+    if (old_last->get().paragraph_start != -1) {
+        display->scroll_to_paragraph(old_last->get().paragraph_start);
+    }
+}
+
+Vector<ChatSessionLog::Entry> ChatTranscript::restore_tail(ChatSessionLog &p_log, int p_count) {
+    // Only the tail is decompressed now; older turns are paged in when scrolled to.
+    int64_t end = p_log.get_entry_count();
+    Vector<ChatSessionLog::Entry> entries = p_log.load_before(end, p_count);
+    for (const ChatSessionLog::Entry &entry : entries) {
+        set_log_index(add_message(Role(entry.role), entry.text), entry.index);
+    }
+    // Restored messages may already have been evicted again by a tight limit.
+    log_resume_index = MAX(log_resume_index, MAX(int64_t(0), end - p_count));
+    return entries;
+}
+
+void ChatTranscript::page_in_older(ChatSessionLog &p_log, int p_count) {
+    // Older turns still in memory sit between the pinned messages and the window.
+    Handle anchor = _get_page_anchor();
+    bool older_in_memory = first_rendered && first_rendered != anchor && !_is_pinned(first_rendered);
+    if (!older_in_memory && log_resume_index > 0) {
+        Vector<ChatSessionLog::Entry> entries = p_log.load_before(log_resume_index, p_count);
+        for (int i = entries.size() - 1; i >= 0; i--) {
+            prepend_message(Role(entries[i].role), entries[i].text, entries[i].index);
+        }
+        log_resume_index = MAX(int64_t(0), log_resume_index - p_count);
+
+        if (display && first_rendered && _is_pinned(first_rendered)) {
+            // The paged-in turns landed inside the window, right below the pinned messages.
+            _render_window(first_rendered);
+            if (anchor && anchor->get().paragraph_start != -1) {
+                display->scroll_to_paragraph(anchor->get().paragraph_start);
+            }
+            return;
+        }
+    }
+    if (has_older()) {
+        show_older(p_count);
+    }
+}
+
+void ChatTranscript::scrolled(ChatSessionLog &p_log, int p_count) {
+    if (!display) {
+        return;
+    }
+    VScrollBar *scroll = display->get_v_scroll_bar();
+    if (scroll->get_value() <= 0.0) {
+        page_in_older(p_log, p_count);
+    } else if (scroll->get_value() >= scroll->get_max() - scroll->get_page() && has_newer()) {
+        show_newer(p_count);
+    }
+}
+
+void ChatTranscript::clear() {
+    messages.clear();
+    first_rendered = nullptr;
+    last_rendered = nullptr;
+    rendered_count = 0;
+    total_length = 0;
+    log_resume_index = 0;
+    if (display) {
+        display->clear();
+    }
+}
@@ -0,0 +1,97 @@
+#ifndef CHAT_TRANSCRIPT_H
+#define CHAT_TRANSCRIPT_H
+
+#include "core/string/ustring.h"
+#include "core/templates/list.h"
+#include "core/templates/vector.h"
+#include "chat_session_log.h"
+
+class RichTextLabel;
+
+// Structured chat history backing a RichTextLabel. Only a window of at most render_window
+// consecutive messages is kept in the label, normally the newest ones, so appending or replacing
+// a reply costs the size of that reply rather than the session.
+class ChatTranscript {
+public:
+    enum Role {
+        ROLE_SYSTEM,
+        ROLE_USER,
+        ROLE_ASSISTANT,
+    };
+
+    struct Block {
+        bool code = false;
+        bool heading = false;
+        String language;
+        String text;
+    };
+
+    struct Message {
+        Role role = ROLE_SYSTEM;
+        String text;
+        Vector<Block> blocks;
+        int parsed_length = 0; // Characters of `text` already split into `blocks`.
+        bool in_code = false;
+        bool pending = false;
+        int paragraph_start = -1; // First paragraph in the display, -1 when not rendered.
+        int paragraph_count = 0;
+        int64_t log_index = -1; // Index in the session log, -1 when not logged.
+    };
+
+    typedef List<Message>::Element *Handle;
+
+private:
+    RichTextLabel *display = nullptr;
+    List<Message> messages;
+    Handle first_rendered = nullptr;
+    Handle last_rendered = nullptr;
+    int rendered_count = 0;
+    int64_t total_length = 0;
+    // Session log messages before this index are not in memory, whether they were never loaded
+    // or evicted since; scrolling up pages them back in from here.
+    int64_t log_resume_index = 0;
+
+    int max_messages = 2000;
+    int64_t max_length = 4 * 1024 * 1024;
+    int render_window = 100;
+
+    void _parse(Message &p_message, bool p_flush);
+    void _render(Message &p_message);
+    void _unrender_tail(Handle p_from);
+    void _unrender_front();
+    void _render_block(const Block &p_block);
+    void _render_window(Handle p_first);
+    void _show_tail();
+    void _rebuild();
+    void _evict();
+    Handle _get_page_anchor() const;
+    bool _is_pinned(Handle p_handle) const;
+
+public:
+    void set_display(RichTextLabel *p_display);
+    void set_limits(int p_max_messages, int64_t p_max_length, int p_render_window);
+
+    Handle add_message(Role p_role, const String &p_text, bool p_pending = false);
+    void append_to_message(Handle p_handle, const String &p_chunk);
+    void replace_message(Handle p_handle, const String &p_text, bool p_pending = false);
+    void prepend_message(Role p_role, const String &p_text, int64_t p_log_index = -1);
+    // Records where a message was written in the session log, see ChatSessionLog::append().
+    void set_log_index(Handle p_handle, int64_t p_log_index);
+
+    bool has_older() const;
+    void show_older(int p_count);
+    bool has_newer() const;
+    void show_newer(int p_count);
+    // Shows the newest messages of a dock's session log and returns them.
+    Vector<ChatSessionLog::Entry> restore_tail(ChatSessionLog &p_log, int p_count);
+    // Called when the display is scrolled to the top: shows older messages still in memory, and
+    // pages them in from the session log once memory has none left.
+    void page_in_older(ChatSessionLog &p_log, int p_count);
+    // Called when the display is scrolled: pages older messages in at the top, and newer ones
+    // back in at the bottom.
+    void scrolled(ChatSessionLog &p_log, int p_count);
+    int get_message_count() const { return messages.size(); }
+    void clear();
+};
+
+#endif // CHAT_TRANSCRIPT_H
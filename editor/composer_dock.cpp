@@ -1,9 +1,26 @@
 #include "composer_dock.h"
 
 #include "core/config/project_settings.h"
+#include "core/io/dir_access.h"
+#include "core/io/file_access.h"
+#include "core/io/json.h"
+#include "core/io/resource.h"
+#include "core/templates/hash_set.h"
 #include "editor/themes/editor_scale.h"
 #include "editor/editor_string_names.h"
+#include "editor/editor_file_system.h"
 #include "editor/editor_node.h"
+#include "editor/editor_undo_redo_manager.h"
+#include "editor/debugger/editor_debugger_node.h"
+#include "editor/plugins/script_editor_plugin.h"
+#include "scene/gui/scroll_bar.h"
+#include "ai_line_diff.h"
+#include "ai_metrics_panel.h"
+#include "ai_trace.h"
+
+static const char *PLAN_SYSTEM_PROMPT = "You plan code changes in a Godot project. Given a task and the project's script files, reply with only a JSON object of the form {\"files\":[{\"path\":\"res://...\",\"instructions\":\"...\"}]} listing every script to create or modify. List each file once. Every file is edited separately, so its instructions must be complete on their own, including names shared with other files.";
+static const char *EDIT_SYSTEM_PROMPT = "You edit one file of a Godot project as part of a larger change. Reply with the complete new content of the file in a single fenced code block and nothing else.";
+static const char *RETRIEVAL_SNAPSHOT_FILE = "ai_composer_retrieval_cache.bin";
 
 void ComposerDock::_notification(int p_what) {
     switch (p_what) {
@@ -22,16 +39,33 @@ void ComposerDock::_notification(int p_what) {
             if (input_field) {
                 input_field->grab_focus();
             }
-            
-            // Initialize AI backend
-            ai_backend = Ref<AIBackend>(memnew(AIBackend));
-            Error err = ai_backend->initialize();
-            if (err != OK) {
-                composer_display->add_text("Error: Failed to initialize AI backend. Please check your settings.\n");
+
+            // Entered again whenever the dock is moved. The backend, its history and any turn in
+            // flight carry over, so they are only set up the first time.
+            if (ai_backend.is_null()) {
+                // Initialize AI backend
+                ai_backend = Ref<AIBackend>(memnew(AIBackend));
+                Error err = ai_backend->initialize();
+                if (err != OK) {
+                    transcript.add_message(ChatTranscript::ROLE_SYSTEM, "Error: Failed to initialize AI backend. Please check your settings.");
+                }
+
+                // Initialize docs retriever
+                _initialize_docs_retriever();
+
+                _restore_session();
+            }
+
+            if (EditorDebuggerNode::get_singleton()) {
+                AIMetricsPanel::install();
             }
+        } break;
 
-            // Initialize docs retriever
-            _initialize_docs_retriever();
+        case NOTIFICATION_EXIT_TREE: {
+            // Cached retrievals are kept for the next editor session.
+            if (docs_retriever.is_valid()) {
+                docs_retriever->save_snapshot_in_project(RETRIEVAL_SNAPSHOT_FILE);
+            }
         } break;
     }
 }
@@ -40,89 +74,404 @@ void ComposerDock::_bind_methods() {
     ClassDB::bind_method(D_METHOD("_send_message"), &ComposerDock::_send_message);
     ClassDB::bind_method(D_METHOD("_on_input_text_changed", "text"), &ComposerDock::_on_input_text_changed);
     ClassDB::bind_method(D_METHOD("_on_input_text_submitted", "text"), &ComposerDock::_on_input_text_submitted);
-    ClassDB::bind_method(D_METHOD("_on_ai_response", "response"), &ComposerDock::_on_ai_response);
-    ClassDB::bind_method(D_METHOD("_on_relevance_response", "is_relevant"), &ComposerDock::_on_relevance_response);
+    // Called by the undo history.
+    ClassDB::bind_method(D_METHOD("_write_file", "path", "content"), &ComposerDock::_write_file);
+    ClassDB::bind_method(D_METHOD("_remove_file", "path"), &ComposerDock::_remove_file);
+    ClassDB::bind_method(D_METHOD("submit_task", "task"), &ComposerDock::submit_task);
+
+    ADD_SIGNAL(MethodInfo("task_finished"));
 }
 
 void ComposerDock::_initialize_docs_retriever() {
     docs_retriever = Ref<GodotDocsRetrieverBind>(memnew(GodotDocsRetrieverBind));
     Error err = docs_retriever->initialize();
     if (err != OK) {
-        composer_display->add_text("Warning: Failed to initialize documentation retriever. Documentation context will not be available.\n");
+        transcript.add_message(ChatTranscript::ROLE_SYSTEM, "Warning: Failed to initialize documentation retriever. Documentation context will not be available.");
+    } else {
+        // Answers the first questions of this session from the previous one's retrievals.
+        docs_retriever->load_snapshot_in_project(RETRIEVAL_SNAPSHOT_FILE);
     }
 }
 
-String ComposerDock::_get_docs_context(const String &p_query) {
+void ComposerDock::_set_stage(Stage p_stage) {
+    stage = p_stage;
+    review_hbox->set_visible(stage == STAGE_REVIEW);
+    // A new task can be started while reviewing; it discards the edits under review.
+    bool accepts_task = stage == STAGE_IDLE || stage == STAGE_REVIEW;
+    input_field->set_editable(accepts_task);
+    send_button->set_disabled(!accepts_task || input_field->get_text().strip_edges().is_empty());
+}
+
+void ComposerDock::_send_message() {
+    String message = input_field->get_text().strip_edges();
+    if (message.is_empty() || (stage != STAGE_IDLE && stage != STAGE_REVIEW)) {
+        return;
+    }
+    if (!ai_backend.is_valid()) {
+        transcript.add_message(ChatTranscript::ROLE_ASSISTANT, "Error - AI backend not initialized.");
+        return;
+    }
+    if (stage == STAGE_REVIEW) {
+        _discard_edits();
+    }
+
+    turn_start_usec = AITrace::now();
+    ChatTranscript::Handle user_message = transcript.add_message(ChatTranscript::ROLE_USER, message);
+    transcript.set_log_index(user_message, session_log.append(ChatTranscript::ROLE_USER, message));
+    input_field->clear();
+
+    task_generation++;
+    task = message;
+    file_edits.clear();
+    files_remaining = 0;
+    _set_stage(STAGE_PLANNING);
+    plan_message = transcript.add_message(ChatTranscript::ROLE_ASSISTANT, "Planning...", true);
+
+    // Fetched once; the plan and every file request share it.
+    docs_context = String();
     if (docs_retriever.is_valid()) {
-        Array results = docs_retriever->search(p_query);
-        if (results.size() > 0) {
-            String formatted_results = docs_retriever->format_results(results);
-            if (!formatted_results.is_empty()) {
-                ERR_PRINT("Formatted documentation results:\n" + formatted_results);
-                return formatted_results;
-            }
+        PackedStringArray parts;
+        docs_retriever->append_docs_context(task, parts);
+        docs_context = String().join(parts);
+    }
+
+    uint64_t prompt_start = AITrace::now();
+    String prompt = _build_plan_prompt();
+    AITrace::record(AITrace::SPAN_PROMPT_BUILD, prompt_start, AITrace::now());
+    if (AITrace::is_verbose_logging()) {
+        print_line("Sending plan request (ComposerDock):\n" + prompt);
+    }
+
+    ai_backend->request_completion(PLAN_SYSTEM_PROMPT, prompt, callable_mp(this, &ComposerDock::_on_plan_response).bind(task_generation));
+}
+
+void ComposerDock::_list_scripts(EditorFileSystemDirectory *p_dir, PackedStringArray &r_paths) {
+    for (int i = 0; i < p_dir->get_file_count() && r_paths.size() < MAX_LISTED_SCRIPTS; i++) {
+        if (ClassDB::is_parent_class(p_dir->get_file_type(i), "Script")) {
+            r_paths.push_back(p_dir->get_file_path(i));
         }
     }
-    return String();
+    for (int i = 0; i < p_dir->get_subdir_count() && r_paths.size() < MAX_LISTED_SCRIPTS; i++) {
+        _list_scripts(p_dir->get_subdir(i), r_paths);
+    }
 }
 
-void ComposerDock::_send_message() {
-    String message = input_field->get_text().strip_edges();
-    if (!message.is_empty()) {
-        composer_display->add_text("You: " + message + "\n");
-        input_field->clear();
-        
-        if (ai_backend.is_valid()) {
-            composer_display->add_text("AI: Thinking...\n");
-            
-            // Store message for use in callback
-            pending_message = message;
-            
-            // Check if the message is relevant to Godot
-            ai_backend->check_godot_relevance(message, callable_mp(this, &ComposerDock::_on_relevance_response));
-        } else {
-            composer_display->add_text("AI: Error - AI backend not initialized.\n");
+String ComposerDock::_build_plan_prompt() const {
+    String prompt = "Task:\n" + task + "\n\n";
+
+    PackedStringArray scripts;
+    if (EditorFileSystem::get_singleton() && EditorFileSystem::get_singleton()->get_filesystem()) {
+        _list_scripts(EditorFileSystem::get_singleton()->get_filesystem(), scripts);
+    }
+    prompt += "Project scripts:\n";
+    for (const String &path : scripts) {
+        prompt += path + "\n";
+    }
+    if (scripts.size() >= MAX_LISTED_SCRIPTS) {
+        prompt += "...\n";
+    }
+
+    if (ScriptEditor::get_singleton()) {
+        Ref<Script> current = ScriptEditor::get_singleton()->get_current_script();
+        if (current.is_valid() && !current->get_path().is_empty()) {
+            prompt += "\nOpen in the script editor: " + current->get_path() + "\n";
         }
     }
+    if (!docs_context.is_empty()) {
+        prompt += "\nRelevant Godot Documentation:\n" + docs_context;
+    }
+    return prompt;
 }
 
-void ComposerDock::_on_relevance_response(bool p_is_relevant) {
-    // Get documentation context only if the message is relevant
-    String docs_context;
-    if (p_is_relevant) {
-        docs_context = _get_docs_context(pending_message);
+String ComposerDock::_build_file_prompt(const FileEdit &p_edit) const {
+    // Everything shared by the task's requests comes first so their prompts start the same.
+    String prompt = "Task:\n" + task + "\n\nPlan:\n";
+    for (const FileEdit &edit : file_edits) {
+        prompt += "- " + edit.path + "\n";
     }
-    
-    // Combine user message with documentation context if relevant
-    String enhanced_message;
-    if (p_is_relevant && !docs_context.is_empty()) {
-        enhanced_message = "User Query: " + pending_message + "\n\n";
-        enhanced_message += "Relevant Godot Documentation:\n" + docs_context + "\n\n";
-        enhanced_message += "Please use the above documentation context to help answer this question: " + pending_message;
+    if (!docs_context.is_empty()) {
+        prompt += "\nRelevant Godot Documentation:\n" + docs_context;
+    }
+
+    prompt += "\nFile: " + p_edit.path + "\nInstructions: " + p_edit.instructions + "\n";
+    if (p_edit.existed) {
+        prompt += "Current content:\n```\n" + p_edit.original + "\n```\n";
     } else {
-        enhanced_message = pending_message;
+        prompt += "This file does not exist yet.\n";
+    }
+    return prompt;
+}
+
+bool ComposerDock::_parse_plan(const String &p_response) {
+    // Models like to wrap JSON in a code fence or a sentence, so only the outermost object is parsed.
+    int start = p_response.find_char('{');
+    int end = p_response.rfind_char('}');
+    if (start == -1 || end <= start) {
+        return false;
+    }
+    JSON json;
+    if (json.parse(p_response.substr(start, end - start + 1)) != OK || json.get_data().get_type() != Variant::DICTIONARY) {
+        return false;
+    }
+
+    Dictionary plan = json.get_data();
+    Array files = plan.get("files", Array());
+    HashSet<String> seen_paths;
+    for (int i = 0; i < files.size() && file_edits.size() < MAX_PLAN_FILES; i++) {
+        if (files[i].get_type() != Variant::DICTIONARY) {
+            continue;
+        }
+        Dictionary file = files[i];
+        String path = String(file.get("path", String())).strip_edges().simplify_path();
+        // Edits stay inside the project.
+        if (!path.begins_with("res://") || path.contains("..") || seen_paths.has(path)) {
+            continue;
+        }
+        seen_paths.insert(path);
+
+        FileEdit edit;
+        edit.path = path;
+        edit.instructions = String(file.get("instructions", String())).strip_edges();
+        edit.original = _read_file(path, &edit.existed);
+        file_edits.push_back(edit);
     }
-    
-    // Log the enhanced message being sent to the LLM
-    ERR_PRINT("Sending to LLM (ComposerDock):\n" + enhanced_message);
-    
-    ai_backend->send_message(enhanced_message, callable_mp(this, &ComposerDock::_on_ai_response));
+    return !file_edits.is_empty();
 }
 
-void ComposerDock::_on_ai_response(const String &p_response) {
-    // Remove only the last line containing "Thinking..."
-    String current_text = composer_display->get_text();
-    int thinking_pos = current_text.rfind("AI: Thinking...\n");
-    if (thinking_pos != -1) {
-        composer_display->remove_paragraph(composer_display->get_paragraph_count() - 2);
+void ComposerDock::_on_plan_response(const String &p_response, int p_generation) {
+    if (p_generation != task_generation || stage != STAGE_PLANNING) {
+        return;
+    }
+
+    if (!_parse_plan(p_response)) {
+        // No usable plan; the reply may still answer the task in prose.
+        String reply = p_response.is_empty() ? String("Error - the plan request failed.") : p_response;
+        // Indexed first, since a replaced message can be evicted right away.
+        transcript.set_log_index(plan_message, session_log.append(ChatTranscript::ROLE_ASSISTANT, reply));
+        transcript.replace_message(plan_message, reply);
+        plan_message = nullptr;
+        _set_stage(STAGE_IDLE);
+        emit_signal(SNAME("task_finished"));
+        return;
+    }
+
+    String plan_text = vformat("Plan: %d files, generating up to %d at a time.\n", file_edits.size(), ai_backend->get_max_parallel_requests());
+    for (const FileEdit &edit : file_edits) {
+        plan_text += "- " + edit.path + (edit.existed ? "" : " (new)") + ": " + edit.instructions + "\n";
+    }
+    transcript.set_log_index(plan_message, session_log.append(ChatTranscript::ROLE_ASSISTANT, plan_text));
+    transcript.replace_message(plan_message, plan_text);
+    plan_message = nullptr;
+
+    // All subtasks are queued at once; the backend's pool bounds how many are in flight, so the
+    // task takes about as long as its slowest file rather than the sum of all of them.
+    _set_stage(STAGE_EDITING);
+    files_remaining = file_edits.size();
+    for (int i = 0; i < file_edits.size(); i++) {
+        FileEdit &edit = file_edits.write[i];
+        edit.message = transcript.add_message(ChatTranscript::ROLE_ASSISTANT, edit.path + ": generating...", true);
+        ai_backend->request_completion(EDIT_SYSTEM_PROMPT, _build_file_prompt(edit), callable_mp(this, &ComposerDock::_on_file_response).bind(task_generation, i));
     }
-    
-    // Add the actual response
-    composer_display->add_text("AI: " + p_response + "\n");
+}
+
+String ComposerDock::_extract_code(const String &p_response) {
+    int fence = p_response.find("```");
+    if (fence == -1) {
+        return p_response.strip_edges() + "\n";
+    }
+    // Skip the language tag on the opening fence.
+    int start = p_response.find_char('\n', fence);
+    if (start == -1) {
+        return String();
+    }
+    start++;
+    int end = p_response.find("```", start);
+    String code = end == -1 ? p_response.substr(start) : p_response.substr(start, end - start);
+    return code.ends_with("\n") ? code : code + "\n";
+}
+
+void ComposerDock::_on_file_response(const String &p_response, int p_generation, int p_index) {
+    if (p_generation != task_generation || stage != STAGE_EDITING || p_index >= file_edits.size()) {
+        return;
+    }
+
+    FileEdit &edit = file_edits.write[p_index];
+    String code = p_response.is_empty() ? String() : _extract_code(p_response);
+    if (code.strip_edges().is_empty()) {
+        edit.state = FILE_FAILED;
+        transcript.replace_message(edit.message, edit.path + ": generation failed, it will be left unchanged.");
+    } else {
+        edit.state = FILE_DONE;
+        edit.updated = code;
+
+        // Shown as soon as this file is ready, while the others are still being generated.
+        Vector<AILineDiff::Line> diff = AILineDiff::compute(edit.original, edit.updated);
+        int added = 0;
+        int removed = 0;
+        AILineDiff::count_changes(diff, added, removed);
+        if (added == 0 && removed == 0) {
+            transcript.replace_message(edit.message, edit.path + ": no changes.");
+        } else {
+            transcript.replace_message(edit.message, vformat("%s (+%d -%d)\n```diff\n%s```", edit.path, added, removed, AILineDiff::format(diff)));
+        }
+    }
+
+    files_remaining--;
+    if (files_remaining == 0) {
+        _finish_editing();
+    }
+}
+
+void ComposerDock::_finish_editing() {
+    int changed = 0;
+    int failed = 0;
+    for (const FileEdit &edit : file_edits) {
+        if (edit.state == FILE_FAILED) {
+            failed++;
+        } else if (edit.updated != edit.original) {
+            changed++;
+        }
+    }
+
+    String summary = vformat("%d of %d files changed in %.1f s.", changed, file_edits.size(), (AITrace::now() - turn_start_usec) / 1000000.0);
+    if (failed > 0) {
+        summary += vformat(" %d failed.", failed);
+    }
+    if (changed > 0) {
+        summary += " Apply them as one undoable action, or discard them.";
+    }
+    ChatTranscript::Handle summary_message = transcript.add_message(ChatTranscript::ROLE_SYSTEM, summary);
+    transcript.set_log_index(summary_message, session_log.append(ChatTranscript::ROLE_SYSTEM, summary));
+    AITrace::record(AITrace::SPAN_TURN, turn_start_usec, AITrace::now());
+
+    _set_stage(changed > 0 ? STAGE_REVIEW : STAGE_IDLE);
+    emit_signal(SNAME("task_finished"));
+}
+
+void ComposerDock::_apply_edits() {
+    if (stage != STAGE_REVIEW) {
+        return;
+    }
+
+    Vector<const FileEdit *> to_apply;
+    String skipped;
+    for (const FileEdit &edit : file_edits) {
+        if (edit.state != FILE_DONE || edit.updated == edit.original) {
+            continue;
+        }
+        bool exists = false;
+        String current = _read_file(edit.path, &exists);
+        if (exists != edit.existed || current != edit.original) {
+            // Edited since the request was made; the generated version is based on stale text.
+            skipped += "\n- " + edit.path;
+            continue;
+        }
+        to_apply.push_back(&edit);
+    }
+
+    if (!to_apply.is_empty()) {
+        EditorUndoRedoManager *undo_redo = EditorUndoRedoManager::get_singleton();
+        undo_redo->create_action(vformat("Apply Composer Edits (%d files)", to_apply.size()));
+        for (const FileEdit *edit : to_apply) {
+            undo_redo->add_do_method(this, "_write_file", edit->path, edit->updated);
+            if (edit->existed) {
+                undo_redo->add_undo_method(this, "_write_file", edit->path, edit->original);
+            } else {
+                undo_redo->add_undo_method(this, "_remove_file", edit->path);
+            }
+        }
+        undo_redo->commit_action();
+    }
+
+    String result = vformat("Applied edits to %d files.", to_apply.size());
+    if (!skipped.is_empty()) {
+        result += " Skipped files changed since the task started:" + skipped;
+    }
+    ChatTranscript::Handle result_message = transcript.add_message(ChatTranscript::ROLE_SYSTEM, result);
+    transcript.set_log_index(result_message, session_log.append(ChatTranscript::ROLE_SYSTEM, result));
+
+    file_edits.clear();
+    _set_stage(STAGE_IDLE);
+}
+
+void ComposerDock::_discard_edits() {
+    if (stage != STAGE_REVIEW) {
+        return;
+    }
+    String discarded = "Discarded the generated edits.";
+    ChatTranscript::Handle discarded_message = transcript.add_message(ChatTranscript::ROLE_SYSTEM, discarded);
+    transcript.set_log_index(discarded_message, session_log.append(ChatTranscript::ROLE_SYSTEM, discarded));
+    file_edits.clear();
+    task_generation++;
+    _set_stage(STAGE_IDLE);
+}
+
+String ComposerDock::_read_file(const String &p_path, bool *r_exists) {
+    // A script open in the editor may have unsaved changes, which are what the user sees.
+    Ref<Script> script = ResourceCache::get_ref(p_path);
+    if (script.is_valid()) {
+        if (r_exists) {
+            *r_exists = true;
+        }
+        return script->get_source_code();
+    }
+    bool exists = FileAccess::exists(p_path);
+    if (r_exists) {
+        *r_exists = exists;
+    }
+    return exists ? FileAccess::get_file_as_string(p_path) : String();
+}
+
+void ComposerDock::_write_file(const String &p_path, const String &p_content) {
+    DirAccess::make_dir_recursive_absolute(p_path.get_base_dir());
+    Error err;
+    Ref<FileAccess> file = FileAccess::open(p_path, FileAccess::WRITE, &err);
+    ERR_FAIL_COND_MSG(file.is_null(), vformat("Cannot write \"%s\": error %d.", p_path, err));
+    file->store_string(p_content);
+    file->close();
+
+    // Keep an open script in sync with the file, so the editor does not offer to overwrite it.
+    Ref<Script> script = ResourceCache::get_ref(p_path);
+    if (script.is_valid()) {
+        script->set_source_code(p_content);
+        script->reload(true);
+    }
+    if (EditorFileSystem::get_singleton()) {
+        EditorFileSystem::get_singleton()->update_file(p_path);
+    }
+    if (ScriptEditor::get_singleton()) {
+        ScriptEditor::get_singleton()->reload_scripts(true);
+    }
+}
+
+void ComposerDock::_remove_file(const String &p_path) {
+    DirAccess::remove_absolute(p_path);
+    if (EditorFileSystem::get_singleton()) {
+        EditorFileSystem::get_singleton()->update_file(p_path);
+    }
+}
+
+void ComposerDock::_on_scroll_changed(double p_value) {
+    // Messages outside the label's window are only put back once the user scrolls to them.
+    transcript.scrolled(session_log, 20);
+}
+
+void ComposerDock::_restore_session() {
+    if (session_log.open_in_project("ai_composer_session.log") != OK) {
+        return;
+    }
+
+    // Tasks are independent requests, so nothing goes back into the backend's history.
+    transcript.restore_tail(session_log, 50);
+}
+
+void ComposerDock::submit_task(const String &p_task) {
+    input_field->set_text(p_task);
+    _send_message();
 }
 
 void ComposerDock::_on_input_text_changed(const String &p_text) {
-    send_button->set_disabled(p_text.strip_edges().is_empty());
+    send_button->set_disabled(p_text.strip_edges().is_empty() || (stage != STAGE_IDLE && stage != STAGE_REVIEW));
 }
 
 void ComposerDock::_on_input_text_submitted(const String &p_text) {
@@ -144,6 +493,26 @@ ComposerDock::ComposerDock() {
     composer_display->set_custom_minimum_size(Size2(0, 100) * EDSCALE);
     composer_display->set_h_size_flags(SIZE_EXPAND_FILL);
     add_child(composer_display);
+    composer_display->get_v_scroll_bar()->connect("value_changed", callable_mp(this, &ComposerDock::_on_scroll_changed));
+    transcript.set_display(composer_display);
+
+    // Review buttons, shown once generated edits are waiting to be applied
+    review_hbox = memnew(HBoxContainer);
+    review_hbox->add_theme_constant_override("separation", 4 * EDSCALE);
+    review_hbox->set_visible(false);
+    add_child(review_hbox);
+
+    apply_button = memnew(Button);
+    apply_button->set_text("Apply All");
+    apply_button->set_h_size_flags(SIZE_EXPAND_FILL);
+    apply_button->connect("pressed", callable_mp(this, &ComposerDock::_apply_edits));
+    review_hbox->add_child(apply_button);
+
+    discard_button = memnew(Button);
+    discard_button->set_text("Discard");
+    discard_button->set_h_size_flags(SIZE_EXPAND_FILL);
+    discard_button->connect("pressed", callable_mp(this, &ComposerDock::_discard_edits));
+    review_hbox->add_child(discard_button);
 
     // Input area container
     HBoxContainer *input_hbox = memnew(HBoxContainer);
@@ -153,7 +522,7 @@ ComposerDock::ComposerDock() {
     // Text input field
     input_field = memnew(LineEdit);
     input_field->set_h_size_flags(SIZE_EXPAND_FILL);
-    input_field->set_placeholder("Type your message here...");
+    input_field->set_placeholder("Describe a change across your scripts...");
     input_field->connect("text_changed", callable_mp(this, &ComposerDock::_on_input_text_changed));
     input_field->connect("text_submitted", callable_mp(this, &ComposerDock::_on_input_text_submitted));
     input_hbox->add_child(input_field);
@@ -166,9 +535,9 @@ ComposerDock::ComposerDock() {
     input_hbox->add_child(send_button);
 
     // Initial welcome message
-    composer_display->add_text("Welcome to the Godot AI Composer! How can I help you today?\n");
+    transcript.add_message(ChatTranscript::ROLE_SYSTEM, "Welcome to the Godot AI Composer! Describe a change and it will be planned per script, generated in parallel and applied as one undoable action.");
 }
 
 ComposerDock::~ComposerDock() {
     // No manual cleanup needed since nodes are freed automatically
-} 
\ No newline at end of file
+}
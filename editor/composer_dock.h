@@ -7,33 +7,99 @@
 #include "scene/gui/button.h"
 #include "ai_backend.h"
 #include "godot_docs_retriever_bind.h"
+#include "chat_session_log.h"
+#include "chat_transcript.h"
 
+class EditorFileSystemDirectory;
+
+// Multi-file edits: a task is planned into one subtask per script, the subtasks are generated
+// concurrently through the backend's request pool, each file's diff is shown as soon as it arrives,
+// and the accepted edits are applied as a single undoable action.
 class ComposerDock : public VBoxContainer {
     GDCLASS(ComposerDock, VBoxContainer);
 
 private:
+    enum {
+        MAX_PLAN_FILES = 12,
+        MAX_LISTED_SCRIPTS = 200,
+    };
+
+    enum Stage {
+        STAGE_IDLE,
+        STAGE_PLANNING,
+        STAGE_EDITING,
+        STAGE_REVIEW,
+    };
+
+    enum FileState {
+        FILE_PENDING,
+        FILE_DONE,
+        FILE_FAILED,
+    };
+
+    struct FileEdit {
+        String path;
+        String instructions;
+        String original;
+        String updated;
+        bool existed = false;
+        FileState state = FILE_PENDING;
+        ChatTranscript::Handle message = nullptr;
+    };
+
     RichTextLabel *composer_display = nullptr;
     LineEdit *input_field = nullptr;
     Button *send_button = nullptr;
+    HBoxContainer *review_hbox = nullptr;
+    Button *apply_button = nullptr;
+    Button *discard_button = nullptr;
     Ref<AIBackend> ai_backend;
     Ref<GodotDocsRetrieverBind> docs_retriever;
-    String pending_message;
+    ChatTranscript transcript;
+    ChatTranscript::Handle plan_message = nullptr;
+    ChatSessionLog session_log;
+    uint64_t turn_start_usec = 0;
+
+    Stage stage = STAGE_IDLE;
+    // Bumped for every task so replies to a discarded task are ignored.
+    int task_generation = 0;
+    String task;
+    String docs_context;
+    Vector<FileEdit> file_edits;
+    int files_remaining = 0;
 
     void _send_message();
     void _on_input_text_changed(const String &p_text);
     void _on_input_text_submitted(const String &p_text);
-    void _on_ai_response(const String &p_response);
-    void _on_relevance_response(bool p_is_relevant);
-    String _get_docs_context(const String &p_query);
+    void _on_plan_response(const String &p_response, int p_generation);
+    void _on_file_response(const String &p_response, int p_generation, int p_index);
+    void _finish_editing();
+    void _apply_edits();
+    void _discard_edits();
+    void _set_stage(Stage p_stage);
+    String _build_plan_prompt() const;
+    String _build_file_prompt(const FileEdit &p_edit) const;
+    bool _parse_plan(const String &p_response);
     void _initialize_docs_retriever();
+    void _on_scroll_changed(double p_value);
+    void _restore_session();
+
+    void _write_file(const String &p_path, const String &p_content);
+    void _remove_file(const String &p_path);
+
+    static String _read_file(const String &p_path, bool *r_exists = nullptr);
+    static String _extract_code(const String &p_response);
+    static void _list_scripts(EditorFileSystemDirectory *p_dir, PackedStringArray &r_paths);
 
 protected:
     void _notification(int p_what);
     static void _bind_methods();
 
 public:
+    void submit_task(const String &p_task);
+
     ComposerDock();
     ~ComposerDock();
 };
 
-#endif // COMPOSER_DOCK_H 
\ No newline at end of file
+#endif // COMPOSER_DOCK_H
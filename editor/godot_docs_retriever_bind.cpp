@@ -1,47 +1,56 @@
 #include "godot_docs_retriever_bind.h"
 
 #include "core/config/project_settings.h"
+#include "core/crypto/crypto_core.h"
+#include "core/io/file_access.h"
 #include "core/io/json.h"
+#include "core/io/marshalls.h"
 #include "core/error/error_macros.h"
+#include "core/object/class_db.h"
+#include "core/string/char_utils.h"
 #include "core/os/os.h"
+#include "editor/editor_paths.h"
+#include "ai_trace.h"
 
 void GodotDocsRetrieverBind::_bind_methods() {
     ClassDB::bind_method(D_METHOD("search", "query", "k"), &GodotDocsRetrieverBind::search, DEFVAL(5));
+    ClassDB::bind_method(D_METHOD("search_batch", "queries", "k"), &GodotDocsRetrieverBind::search_batch, DEFVAL(5));
+    ClassDB::bind_method(D_METHOD("search_with_expansion", "query", "k"), &GodotDocsRetrieverBind::search_with_expansion, DEFVAL(5));
     ClassDB::bind_method(D_METHOD("format_results", "results"), &GodotDocsRetrieverBind::format_results);
     ClassDB::bind_method(D_METHOD("initialize"), &GodotDocsRetrieverBind::initialize);
+    ClassDB::bind_method(D_METHOD("save_snapshot", "path"), &GodotDocsRetrieverBind::save_snapshot);
+    ClassDB::bind_method(D_METHOD("load_snapshot", "path"), &GodotDocsRetrieverBind::load_snapshot);
 }
 
-GodotDocsRetrieverBind::GodotDocsRetrieverBind() {
+GodotDocsRetrieverBind::GodotDocsRetrieverBind() :
+        result_cache(RESULT_CACHE_SIZE) {
 }
 
 GodotDocsRetrieverBind::~GodotDocsRetrieverBind() {
 }
 
 String GodotDocsRetrieverBind::_run_python_script(const String &script, const Array &args) {
-    ERR_PRINT("Starting Python script execution...");
+    bool verbose = AITrace::is_verbose_logging();
     
     String python_path = OS::get_singleton()->get_environment("VIRTUAL_ENV");
-    ERR_PRINT("VIRTUAL_ENV: " + python_path);
-    
     if (python_path.is_empty()) {
-        ERR_PRINT("VIRTUAL_ENV not set, using default python3");
         python_path = "python3";
     } else {
         python_path = python_path + "/bin/python3";
-        ERR_PRINT("Using Python from virtualenv: " + python_path);
     }
 
     // Get the executable path and use its directory
     String exec_path = OS::get_singleton()->get_executable_path();
     String base_dir = exec_path.get_base_dir();
     String project_root = base_dir.get_base_dir();
-    ERR_PRINT("Executable directory: " + base_dir);
-    ERR_PRINT("Project root: " + project_root);
 
     // Set up environment variables
     OS::get_singleton()->set_environment("PYTHONPATH", project_root);
     OS::get_singleton()->set_environment("PYTHONUNBUFFERED", "1");
-    ERR_PRINT("Setting PYTHONPATH: " + project_root);
+    OS::get_singleton()->set_environment("GODOT_AI_VERBOSE", verbose ? "1" : "0");
+    if (verbose) {
+        print_line("Running Python retriever script with " + python_path + ", PYTHONPATH: " + project_root);
+    }
 
     List<String> args_list;
     args_list.push_back("-c");
@@ -53,7 +62,11 @@ import sys
 import traceback
 import json
 
+VERBOSE = os.environ.get('GODOT_AI_VERBOSE') == '1'
+
 def log(message, is_error=False):
+    if not VERBOSE and not is_error:
+        return
     try:
         output = {
             'type': 'error' if is_error else 'debug',
@@ -107,7 +120,6 @@ if __name__ == '__main__':
 
     String output;
     int exit_code = 0;
-    ERR_PRINT("Executing Python command: " + python_path);
     Error err = OS::get_singleton()->execute(python_path, args_list, &output, &exit_code, true);
     
     if (err != OK) {
@@ -115,8 +127,9 @@ if __name__ == '__main__':
         return String();
     }
     
-    ERR_PRINT("Python script output: " + output);
-    ERR_PRINT("Python script exit code: " + itos(exit_code));
+    if (verbose) {
+        print_line("Python script exit code " + itos(exit_code) + ", output:\n" + output);
+    }
     
     if (exit_code != 0) {
         ERR_PRINT("Python script execution failed with code " + itos(exit_code) + ": " + output);
@@ -147,8 +160,6 @@ if __name__ == '__main__':
 }
 
 Error GodotDocsRetrieverBind::initialize() {
-    ERR_PRINT("Initializing GodotDocsRetrieverBind...");
-    
     String script = R"(
 # Initialize the retriever
 log('Starting initialization')
@@ -162,42 +173,190 @@ log('Successfully imported GodotDocsRetriever')
 
 log('Attempting to initialize GodotDocsRetriever')
 retriever = GodotDocsRetriever()
+# Builds the warm-start snapshot once, so later searches map it instead of loading the store.
+fingerprint = retriever.warm_start()
 log('Successfully initialized GodotDocsRetriever')
 
-print(json.dumps({'type': 'success', 'message': 'OK'}), flush=True)
+print(json.dumps({'type': 'success', 'message': 'OK', 'fingerprint': fingerprint}), flush=True)
 )";
 
     String result = _run_python_script(script, Array());
-    ERR_PRINT("Initialization result: " + result);
     
     // Parse the JSON output to check for success
     Variant json_result = JSON::parse_string(result);
     if (json_result.get_type() == Variant::DICTIONARY) {
         Dictionary dict = json_result;
         if (dict.has("type") && String(dict["type"]) == "success") {
+            store_fingerprint = dict.get("fingerprint", String());
             return OK;
         }
     }
     return ERR_CANT_CREATE;
 }
 
+String GodotDocsRetrieverBind::_get_cache_key(const String &query, int k) {
+    return itos(k) + ":" + query;
+}
+
+Array GodotDocsRetrieverBind::_cache_insert(const String &p_key, const Array &p_results) {
+    cache_keys.push_back(p_key);
+    if (cache_keys.size() > RESULT_CACHE_SIZE * 2) {
+        // Drop evicted and repeated keys, keeping the latest position of each.
+        LocalVector<String> live_keys;
+        HashSet<String> seen;
+        for (int64_t i = int64_t(cache_keys.size()) - 1; i >= 0; i--) {
+            if (result_cache.has(cache_keys[i]) && !seen.has(cache_keys[i])) {
+                seen.insert(cache_keys[i]);
+                live_keys.push_back(cache_keys[i]);
+            }
+        }
+        live_keys.invert();
+        cache_keys = live_keys;
+    }
+    result_cache.insert(p_key, p_results);
+    return p_results;
+}
+
+Error GodotDocsRetrieverBind::save_snapshot(const String &p_path) {
+    if (store_fingerprint.is_empty()) {
+        return ERR_UNCONFIGURED;
+    }
+
+    Array entries;
+    HashSet<String> seen;
+    for (int64_t i = int64_t(cache_keys.size()) - 1; i >= 0; i--) {
+        const String &key = cache_keys[i];
+        if (seen.has(key) || !result_cache.has(key)) {
+            continue;
+        }
+        seen.insert(key);
+        Array entry;
+        entry.push_back(key);
+        entry.push_back(*result_cache.getptr(key));
+        entries.push_back(entry);
+    }
+    // Oldest first, so reinserting them in order restores the most recent as most recent.
+    entries.reverse();
+
+    Dictionary snapshot;
+    snapshot["fingerprint"] = store_fingerprint;
+    snapshot["entries"] = entries;
+
+    int length = 0;
+    Error err = encode_variant(snapshot, nullptr, length);
+    ERR_FAIL_COND_V(err != OK, err);
+    PackedByteArray payload;
+    payload.resize(length);
+    encode_variant(snapshot, payload.ptrw(), length);
+    unsigned char hash[32];
+    CryptoCore::sha256(payload.ptr(), payload.size(), hash);
+
+    Ref<FileAccess> file = FileAccess::open(p_path, FileAccess::WRITE, &err);
+    ERR_FAIL_COND_V_MSG(file.is_null(), err, "Cannot write retrieval cache snapshot: " + p_path);
+    file->store_32(SNAPSHOT_VERSION);
+    file->store_buffer(hash, 32);
+    file->store_32(payload.size());
+    file->store_buffer(payload.ptr(), payload.size());
+    return OK;
+}
+
+Error GodotDocsRetrieverBind::load_snapshot(const String &p_path) {
+    if (store_fingerprint.is_empty() || !FileAccess::exists(p_path)) {
+        return ERR_UNCONFIGURED;
+    }
+    Ref<FileAccess> file = FileAccess::open(p_path, FileAccess::READ);
+    if (file.is_null() || file->get_length() < 40 || file->get_32() != SNAPSHOT_VERSION) {
+        return ERR_FILE_UNRECOGNIZED;
+    }
+
+    unsigned char stored_hash[32];
+    file->get_buffer(stored_hash, 32);
+    uint32_t length = file->get_32();
+    if (length != file->get_length() - file->get_position()) {
+        return ERR_FILE_CORRUPT;
+    }
+    PackedByteArray payload;
+    payload.resize(length);
+    file->get_buffer(payload.ptrw(), length);
+    unsigned char hash[32];
+    CryptoCore::sha256(payload.ptr(), payload.size(), hash);
+    if (memcmp(hash, stored_hash, 32) != 0) {
+        return ERR_FILE_CORRUPT;
+    }
+
+    Variant decoded;
+    if (decode_variant(decoded, payload.ptr(), payload.size()) != OK || decoded.get_type() != Variant::DICTIONARY) {
+        return ERR_FILE_CORRUPT;
+    }
+    Dictionary snapshot = decoded;
+    if (String(snapshot.get("fingerprint", String())) != store_fingerprint) {
+        // The documentation changed since these results were cached.
+        return ERR_INVALID_DATA;
+    }
+
+    Array entries = snapshot.get("entries", Array());
+    for (int i = 0; i < entries.size(); i++) {
+        Array entry = entries[i];
+        if (entry.size() == 2 && entry[0].get_type() == Variant::STRING && entry[1].get_type() == Variant::ARRAY) {
+            _cache_insert(entry[0], entry[1]);
+        }
+    }
+    if (AITrace::is_verbose_logging()) {
+        print_line(vformat("Restored %d cached retrieval results from %s", entries.size(), p_path));
+    }
+    return OK;
+}
+
+Error GodotDocsRetrieverBind::save_snapshot_in_project(const String &p_file) {
+    if (!EditorPaths::get_singleton()) {
+        return ERR_UNAVAILABLE;
+    }
+    return save_snapshot(EditorPaths::get_singleton()->get_project_settings_dir().path_join(p_file));
+}
+
+Error GodotDocsRetrieverBind::load_snapshot_in_project(const String &p_file) {
+    if (!EditorPaths::get_singleton()) {
+        return ERR_UNAVAILABLE;
+    }
+    return load_snapshot(EditorPaths::get_singleton()->get_project_settings_dir().path_join(p_file));
+}
+
 Array GodotDocsRetrieverBind::search(const String &query, int k) {
+    String cache_key = _get_cache_key(query, k);
+    const Array *cached = result_cache.getptr(cache_key);
+    AITrace::record_cache(AITrace::CACHE_RETRIEVAL, cached != nullptr);
+    if (cached) {
+        return *cached;
+    }
+
     String script = R"(
 # Search the documentation
 from godot_docs_retriever import GodotDocsRetriever
 
+import time
+
+start = time.perf_counter()
 retriever = GodotDocsRetriever()
+loaded = time.perf_counter()
 results = retriever.search(sys.argv[1], int(sys.argv[2]))
+searched = time.perf_counter()
+retriever.save_snapshot()
 print(json.dumps({
     'type': 'result',
     'message': [{
         'content': r['content'],
         'metadata': r['metadata'],
         'relevance': r['relevance']
-    } for r in results]
+    } for r in results],
+    'timings': {
+        'load_usec': int((loaded - start) * 1e6),
+        'search_usec': int((searched - loaded) * 1e6)
+    }
 }))
 )";
 
+    AITraceScope trace_scope(AITrace::SPAN_RETRIEVAL);
+
     Array args;
     args.push_back(query);
     args.push_back(String::num_int64(k));
@@ -212,32 +371,179 @@ print(json.dumps({
     if (json_result.get_type() == Variant::DICTIONARY) {
         Dictionary dict = json_result;
         if (dict.has("type") && String(dict["type"]) == "result") {
-            return dict["message"];
+            // Query embedding and vector lookup as measured inside the Python process.
+            Dictionary timings = dict.get("timings", Dictionary());
+            if (timings.has("search_usec")) {
+                uint64_t end = AITrace::now();
+                AITrace::record(AITrace::SPAN_EMBEDDING, end - uint64_t(timings["search_usec"]), end);
+            }
+            return _cache_insert(cache_key, dict["message"]);
         }
     }
 
     return Array();
 }
 
-String GodotDocsRetrieverBind::format_results(const Array &results) {
-    if (results.is_empty()) {
-        return String();
+Array GodotDocsRetrieverBind::search_batch(const PackedStringArray &queries, int k) {
+    String script = R"(
+# Search the documentation for several queries in one batched pass
+from godot_docs_retriever import GodotDocsRetriever
+
+import time
+
+start = time.perf_counter()
+retriever = GodotDocsRetriever()
+loaded = time.perf_counter()
+batch = retriever.search_batch(json.loads(sys.argv[1]), int(sys.argv[2]))
+searched = time.perf_counter()
+retriever.save_snapshot()
+print(json.dumps({
+    'type': 'result',
+    'message': [[{
+        'content': r['content'],
+        'metadata': r['metadata'],
+        'relevance': r['relevance']
+    } for r in results] for results in batch],
+    'timings': {
+        'load_usec': int((loaded - start) * 1e6),
+        'search_usec': int((searched - loaded) * 1e6)
+    }
+}))
+)";
+
+    Array results;
+    results.resize(queries.size());
+
+    // Only queries that are not cached go to Python.
+    Array misses;
+    Vector<int> miss_positions;
+    for (int i = 0; i < queries.size(); i++) {
+        const Array *cached = result_cache.getptr(_get_cache_key(queries[i], k));
+        AITrace::record_cache(AITrace::CACHE_RETRIEVAL, cached != nullptr);
+        if (cached) {
+            results[i] = *cached;
+        } else {
+            results[i] = Array();
+            misses.push_back(queries[i]);
+            miss_positions.push_back(i);
+        }
+    }
+    if (misses.is_empty()) {
+        return results;
+    }
+
+    AITraceScope trace_scope(AITrace::SPAN_RETRIEVAL);
+
+    Array args;
+    args.push_back(JSON::stringify(misses));
+    args.push_back(String::num_int64(k));
+
+    String output = _run_python_script(script, args);
+    if (output.is_empty()) {
+        return results;
+    }
+
+    Variant json_result = JSON::parse_string(output);
+    if (json_result.get_type() == Variant::DICTIONARY) {
+        Dictionary dict = json_result;
+        if (dict.has("type") && String(dict["type"]) == "result") {
+            Dictionary timings = dict.get("timings", Dictionary());
+            if (timings.has("search_usec")) {
+                uint64_t end = AITrace::now();
+                AITrace::record(AITrace::SPAN_EMBEDDING, end - uint64_t(timings["search_usec"]), end);
+            }
+            Array batch = dict["message"];
+            for (int i = 0; i < batch.size() && i < miss_positions.size(); i++) {
+                results[miss_positions[i]] = _cache_insert(_get_cache_key(misses[i], k), batch[i]);
+            }
+        }
+    }
+
+    return results;
+}
+
+Array GodotDocsRetrieverBind::search_with_expansion(const String &query, int k) {
+    // The question itself, plus one short sub-query per engine class it mentions.
+    PackedStringArray queries;
+    queries.push_back(query);
+    int word_start = -1;
+    for (int i = 0; i <= query.length() && queries.size() < MAX_EXPANDED_QUERIES; i++) {
+        bool identifier = i < query.length() && is_ascii_identifier_char(query[i]);
+        if (identifier && word_start < 0) {
+            word_start = i;
+        } else if (!identifier && word_start >= 0) {
+            String word = query.substr(word_start, i - word_start);
+            word_start = -1;
+            String sub_query = word + " class reference";
+            if (word.length() > 2 && is_ascii_upper_case(word[0]) && ClassDB::class_exists(word) && !queries.has(sub_query)) {
+                queries.push_back(sub_query);
+            }
+        }
+    }
+
+    Array batch;
+    if (queries.size() == 1) {
+        batch.push_back(search(query, k));
+    } else {
+        batch = search_batch(queries, k);
     }
 
-    String formatted = "Here are the most relevant sections from the Godot documentation:\n\n";
+    // Interleave by rank so every sub-query is represented before any gets a second slot.
+    int limit = k + queries.size() - 1;
+    Array merged;
     HashSet<String> seen_content;
-    
-    for (int i = 0; i < results.size(); i++) {
-        Dictionary result = results[i];
+    for (int rank = 0; rank < k && merged.size() < limit; rank++) {
+        for (int i = 0; i < batch.size() && merged.size() < limit; i++) {
+            Array results = batch[i];
+            if (rank >= results.size()) {
+                continue;
+            }
+            Dictionary result = results[rank];
+            String content = result.get("content", String());
+            if (!seen_content.has(content)) {
+                seen_content.insert(content);
+                merged.push_back(result);
+            }
+        }
+    }
+    return merged;
+}
+
+void GodotDocsRetrieverBind::append_result_parts(const Array &p_results, PackedStringArray &r_parts) {
+    if (p_results.is_empty()) {
+        return;
+    }
+
+    // The contents are pushed as they are, so they are shared with the cached results and only
+    // copied once, when escaped into a request body.
+    r_parts.push_back("Here are the most relevant sections from the Godot documentation:\n\n");
+    HashSet<String> seen_content;
+    for (int i = 0; i < p_results.size(); i++) {
+        Dictionary result = p_results[i];
         if (result.has("content") && result.has("relevance")) {
-            String content = String(result["content"]);
+            String content = result["content"];
             if (!seen_content.has(content)) {
                 seen_content.insert(content);
-                formatted += vformat("[Result %d] (Relevance: %.2f)\n", seen_content.size(), (double)result["relevance"]);
-                formatted += content + "\n\n";
+                r_parts.push_back(vformat("[Result %d] (Relevance: %.2f)\n", seen_content.size(), double(result["relevance"])));
+                r_parts.push_back(content);
+                r_parts.push_back("\n\n");
             }
         }
     }
-    
-    return formatted;
-} 
\ No newline at end of file
+}
+
+void GodotDocsRetrieverBind::append_docs_context(const String &p_query, PackedStringArray &r_parts) {
+    PackedStringArray parts;
+    append_result_parts(search_with_expansion(p_query), parts);
+    if (AITrace::is_verbose_logging() && !parts.is_empty()) {
+        print_line("Formatted documentation results:\n" + String().join(parts));
+    }
+    r_parts.append_array(parts);
+}
+
+String GodotDocsRetrieverBind::format_results(const Array &results) {
+    PackedStringArray parts;
+    append_result_parts(results, parts);
+    // join() sizes the result from the parts, so the text is written into one allocation.
+    return String().join(parts);
+}
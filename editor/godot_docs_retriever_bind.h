@@ -3,11 +3,26 @@
 
 #include "core/object/ref_counted.h"
 #include "core/string/ustring.h"
+#include "core/templates/local_vector.h"
+#include "core/templates/lru.h"
 #include "core/variant/array.h"
 
 class GodotDocsRetrieverBind : public RefCounted {
     GDCLASS(GodotDocsRetrieverBind, RefCounted);
 
+    enum {
+        RESULT_CACHE_SIZE = 256,
+        MAX_EXPANDED_QUERIES = 4,
+        SNAPSHOT_VERSION = 1,
+    };
+
+    // Results per (k, query), so repeated and expanded queries skip the Python round trip.
+    LRUCache<String, Array> result_cache;
+    // Keys in insertion order, since the cache itself cannot be iterated when saving it.
+    LocalVector<String> cache_keys;
+    // Identifies the documentation store the results came from, as reported by Python.
+    String store_fingerprint;
+
 protected:
     static void _bind_methods();
 
@@ -16,11 +31,27 @@ public:
     ~GodotDocsRetrieverBind();
 
     Array search(const String &query, int k = 5);
+    Array search_batch(const PackedStringArray &queries, int k = 5);
+    Array search_with_expansion(const String &query, int k = 5);
     String format_results(const Array &results);
+    // The formatted results as separate parts, for callers that write them out piece by piece.
+    static void append_result_parts(const Array &p_results, PackedStringArray &r_parts);
+    // Expanded search for a question, appended as result parts. Nothing is appended when nothing
+    // relevant was found.
+    void append_docs_context(const String &p_query, PackedStringArray &r_parts);
     Error initialize();
+    // The result cache survives editor restarts through these. A snapshot is only loaded when it
+    // is intact and was taken against the same documentation store.
+    Error save_snapshot(const String &p_path);
+    Error load_snapshot(const String &p_path);
+    // The same, for a file in the project's editor settings directory.
+    Error save_snapshot_in_project(const String &p_file);
+    Error load_snapshot_in_project(const String &p_file);
 
 private:
     String _run_python_script(const String &script, const Array &args);
+    static String _get_cache_key(const String &query, int k);
+    Array _cache_insert(const String &p_key, const Array &p_results);
 };
 
 #endif // GODOT_DOCS_RETRIEVER_BIND_H 
\ No newline at end of file
@@ -1,14 +1,89 @@
 from langchain_community.vectorstores import Chroma
 from langchain_community.embeddings import HuggingFaceEmbeddings
-from typing import List, Dict
+from langchain_core.vectorstores import VectorStore
+from collections import OrderedDict
+from typing import List, Dict, Optional
+
+import hashlib
+import json
+import os
+import struct
+
+import numpy as np
+
+MODEL_NAME = "all-MiniLM-L6-v2"
+SNAPSHOT_VERSION = 1
+QUERY_CACHE_SIZE = 4096
+QUERY_CACHE_FILE = "query_cache.bin"
+# Magic, version, vector dimension and a hash of the model name.
+QUERY_CACHE_HEADER = struct.Struct("<4sII32s")
+QUERY_CACHE_MAGIC = b"GDQC"
+
+# Chroma's relevance functions per distance space, usable without opening the store.
+RELEVANCE_SCORE_FNS = {
+    "l2": VectorStore._euclidean_relevance_score_fn,
+    "cosine": VectorStore._cosine_relevance_score_fn,
+    "ip": VectorStore._max_inner_product_relevance_score_fn,
+}
+
+def _query_record_dtype(dim: int) -> np.dtype:
+    # The key and its vector share one fixed-size record, so they are written and torn together.
+    # Raw bytes rather than "S" fields, which would drop a digest's trailing zero bytes.
+    return np.dtype([("key", "u1", (32,)), ("checksum", "u1", (8,)), ("vector", "<f4", (dim,))])
+
+
+def _query_record_checksum(key: bytes, vector: np.ndarray) -> bytes:
+    return hashlib.sha256(key + np.ascontiguousarray(vector, dtype="<f4").tobytes()).digest()[:8]
+
 
 class GodotDocsRetriever:
-    def __init__(self, persist_directory: str = "./chroma_db"):
-        self.embeddings = HuggingFaceEmbeddings(model_name="all-MiniLM-L6-v2")
-        self.vectorstore = Chroma(
-            persist_directory=persist_directory,
-            embedding_function=self.embeddings
-        )
+    def __init__(self, persist_directory: str = "./chroma_db", snapshot_directory: Optional[str] = None):
+        """
+        Args:
+            persist_directory (str): The Chroma store
+            snapshot_directory (str): Where the warm-start snapshot lives, next to the store by
+                default. An empty string disables the snapshot.
+        """
+        self.persist_directory = persist_directory
+        if snapshot_directory is None:
+            snapshot_directory = os.path.normpath(persist_directory) + "_warm_start"
+        self.snapshot_directory = snapshot_directory
+        self._embeddings = None
+        self._vectorstore = None
+        self._matrix = None
+        self._documents = None
+        self._metadatas = None
+        self._space = None
+        self._store_fingerprint = None
+        self._matrix_from_snapshot = False
+        # Query text hash -> normalized embedding, least recently used first. Entries read from
+        # the snapshot hold their row in _query_records until they are first used.
+        self._query_cache = OrderedDict()
+        self._query_records = None
+        # Rows and vector size of the snapshot's query cache file; rows is None when it has to be
+        # rewritten.
+        self._query_file_rows = None
+        self._query_file_dim = 0
+        # Keys embedded by this process and not yet saved.
+        self._new_query_keys = []
+        if self.snapshot_directory:
+            self._load_snapshot()
+
+    @property
+    def embeddings(self):
+        # Loading the model dominates a cold start, so it only happens when a query is not cached.
+        if self._embeddings is None:
+            self._embeddings = HuggingFaceEmbeddings(model_name=MODEL_NAME)
+        return self._embeddings
+
+    @property
+    def vectorstore(self):
+        if self._vectorstore is None:
+            self._vectorstore = Chroma(
+                persist_directory=self.persist_directory,
+                embedding_function=self.embeddings
+            )
+        return self._vectorstore
     
     def search(self, query: str, k: int = 5) -> List[Dict]:
         """
@@ -21,6 +96,13 @@ class GodotDocsRetriever:
         Returns:
             List[Dict]: List of documents with their content and metadata
         """
+        if self._matrix is not None:
+            # Served from the snapshot without opening the store or, for a cached query, the model.
+            return self.search_batch([query], k)[0]
+        return self._search_store(query, k)
+
+    def _search_store(self, query: str, k: int) -> List[Dict]:
+        """Search through Chroma's own index, for when no chunk matrix is mapped."""
         docs = self.vectorstore.similarity_search_with_relevance_scores(query, k=k)
         results = []
         
@@ -33,6 +115,287 @@ class GodotDocsRetriever:
         
         return results
     
+    def _load_matrix(self):
+        """Pull every chunk embedding out of the store once, L2-normalized, for batched scoring."""
+        if self._matrix is None:
+            data = self.vectorstore._collection.get(include=["embeddings", "documents", "metadatas"])
+            matrix = np.asarray(data["embeddings"], dtype=np.float32).reshape(len(data["documents"]), -1)
+            norms = np.linalg.norm(matrix, axis=1, keepdims=True)
+            self._matrix = matrix / np.maximum(norms, 1e-12)
+            self._documents = data["documents"]
+            self._metadatas = [metadata or {} for metadata in data["metadatas"]]
+            self._space = (self.vectorstore._collection.metadata or {}).get("hnsw:space", "l2")
+        return self._matrix
+
+    def _relevance(self, similarity: np.ndarray) -> np.ndarray:
+        """Map cosine similarity to the same relevance score search() reports for this store."""
+        # Chroma reports squared L2 for "l2", and 1 - similarity for "cosine" and "ip".
+        distance = 2.0 - 2.0 * similarity if self._space == "l2" else 1.0 - similarity
+        score_fn = RELEVANCE_SCORE_FNS[self._space]
+        return np.array([score_fn(float(d)) for d in distance.ravel()]).reshape(similarity.shape)
+
+    def search_batch(self, queries: List[str], k: int = 5, block_size: int = 8192) -> List[List[Dict]]:
+        """
+        Search the documentation for several queries at once.
+
+        All queries are embedded in one batched forward pass and scored against the chunk
+        matrix with one matrix-matrix product per block of chunks, so a handful of sub-queries
+        costs about as much as one. Without a valid snapshot every query goes through the store's
+        own index instead; copying the whole collection out of Chroma would cost this process far
+        more than the batching saves, and building the matrix is left to warm_start().
+
+        Args:
+            queries (List[str]): The search queries
+            k (int): Number of results to return per query
+            block_size (int): Number of chunks scored per matrix product
+
+        Returns:
+            List[List[Dict]]: One result list per query, in the same format as search()
+        """
+        if not queries:
+            return []
+        if self._matrix is None:
+            return [self._search_store(query, k) for query in queries]
+        matrix = self._matrix
+        if matrix.shape[0] == 0:
+            return [[] for _ in queries]
+
+        query_matrix = self._embed_queries(queries)
+
+        k = min(k, matrix.shape[0])
+        best_scores = np.full((len(queries), 0), -np.inf, dtype=np.float32)
+        best_indices = np.zeros((len(queries), 0), dtype=np.int64)
+        for start in range(0, matrix.shape[0], block_size):
+            block = matrix[start:start + block_size]
+            scores = np.concatenate([best_scores, query_matrix @ block.T], axis=1)
+            indices = np.concatenate([best_indices, np.broadcast_to(
+                np.arange(start, start + block.shape[0]), (len(queries), block.shape[0]))], axis=1)
+            # Keep only the running top k of every query between blocks.
+            if scores.shape[1] > k:
+                keep = np.argpartition(-scores, k - 1, axis=1)[:, :k]
+                scores = np.take_along_axis(scores, keep, axis=1)
+                indices = np.take_along_axis(indices, keep, axis=1)
+            best_scores, best_indices = scores, indices
+
+        order = np.argsort(-best_scores, axis=1)
+        best_scores = np.take_along_axis(best_scores, order, axis=1)
+        best_indices = np.take_along_axis(best_indices, order, axis=1)
+        relevance = self._relevance(best_scores)
+
+        return [[{
+            "content": self._documents[index],
+            "metadata": self._metadatas[index],
+            "relevance": float(relevance[row, column])
+        } for column, index in enumerate(best_indices[row])] for row in range(len(queries))]
+
+    def _embed_queries(self, queries: List[str]) -> np.ndarray:
+        """Normalized query embeddings, embedding only the queries not already cached."""
+        keys = [hashlib.sha256((MODEL_NAME + "\0" + query).encode("utf-8")).digest() for query in queries]
+        missing = [i for i, key in enumerate(keys) if self._cached_query_vector(key) is None]
+        if missing:
+            vectors = np.asarray(self.embeddings.embed_documents([queries[i] for i in missing]), dtype=np.float32)
+            vectors /= np.maximum(np.linalg.norm(vectors, axis=1, keepdims=True), 1e-12)
+            for i, vector in zip(missing, vectors):
+                if keys[i] not in self._query_cache:
+                    self._new_query_keys.append(keys[i])
+                self._query_cache[keys[i]] = vector
+        for key in keys:
+            self._query_cache.move_to_end(key)
+        # Stacked before trimming, which could otherwise evict part of an oversized batch.
+        vectors = np.stack([self._query_cache[key] for key in keys])
+        while len(self._query_cache) > QUERY_CACHE_SIZE:
+            self._query_cache.popitem(last=False)
+        return vectors
+
+    def _cached_query_vector(self, key: bytes) -> Optional[np.ndarray]:
+        """The cached embedding for a query key, checked against its record on first use."""
+        value = self._query_cache.get(key)
+        if isinstance(value, int):
+            record = self._query_records[value]
+            if _query_record_checksum(key, record["vector"]) != record["checksum"].tobytes():
+                del self._query_cache[key]
+                return None
+            # A view into the mapping; only the rows used are paged in.
+            value = self._query_cache[key] = self._query_records["vector"][value]
+        return value
+
+    def _get_store_fingerprint(self) -> str:
+        """
+        Hash of the store's file names, sizes and modification times.
+
+        Hashing the store's contents would cost more than the snapshot saves, and any write to
+        the store changes at least one of these.
+        """
+        if self._store_fingerprint is None:
+            digest = hashlib.sha256(f"{SNAPSHOT_VERSION}\0{MODEL_NAME}\n".encode("utf-8"))
+            for root, dirs, files in os.walk(self.persist_directory):
+                dirs.sort()
+                for name in sorted(files):
+                    path = os.path.join(root, name)
+                    stat = os.stat(path)
+                    relative = os.path.relpath(path, self.persist_directory)
+                    digest.update(f"{relative}\0{stat.st_size}\0{stat.st_mtime_ns}\n".encode("utf-8"))
+            self._store_fingerprint = digest.hexdigest()
+        return self._store_fingerprint
+
+    def _snapshot_path(self, name: str) -> str:
+        return os.path.join(self.snapshot_directory, name)
+
+    def _load_snapshot(self):
+        """Map the chunk matrix and query cache written by an earlier process, if still valid."""
+        self._load_query_cache()
+
+        try:
+            with open(self._snapshot_path("manifest.json"), encoding="utf-8") as f:
+                manifest = json.load(f)
+            if manifest.get("version") != SNAPSHOT_VERSION or manifest.get("store_fingerprint") != self._get_store_fingerprint():
+                return
+            matrix = np.load(self._snapshot_path("matrix.npy"), mmap_mode="r")
+            if matrix.dtype != np.float32 or matrix.shape != (manifest["count"], manifest["dim"]):
+                return
+            with open(self._snapshot_path("documents.json"), encoding="utf-8") as f:
+                documents = json.load(f)
+            if len(documents["documents"]) != matrix.shape[0] or manifest["space"] not in RELEVANCE_SCORE_FNS:
+                return
+        except (OSError, ValueError, KeyError):
+            return
+        self._matrix = matrix
+        self._documents = documents["documents"]
+        self._metadatas = documents["metadatas"]
+        self._space = manifest["space"]
+        self._matrix_from_snapshot = True
+
+    def _load_query_cache(self):
+        """Index the query cache file by key; the vectors are only read and checked when used."""
+        path = self._snapshot_path(QUERY_CACHE_FILE)
+        try:
+            with open(path, "rb") as f:
+                magic, version, dim, model = QUERY_CACHE_HEADER.unpack(f.read(QUERY_CACHE_HEADER.size))
+            if (magic != QUERY_CACHE_MAGIC or version != SNAPSHOT_VERSION or dim == 0
+                    or model != hashlib.sha256(MODEL_NAME.encode("utf-8")).digest()):
+                return
+            dtype = _query_record_dtype(dim)
+            # A record torn by a crash is left out here and overwritten by the next append.
+            rows = (os.path.getsize(path) - QUERY_CACHE_HEADER.size) // dtype.itemsize
+            self._query_file_rows = rows
+            self._query_file_dim = dim
+            if rows == 0:
+                return
+            self._query_records = np.memmap(path, dtype=dtype, mode="r", offset=QUERY_CACHE_HEADER.size, shape=(rows,))
+        except (OSError, ValueError, struct.error):
+            self._query_file_rows = None
+            self._query_records = None
+            return
+        # Later records are newer, and a key appended twice keeps its latest row.
+        first = max(0, rows - QUERY_CACHE_SIZE * 2)
+        for row, key in enumerate(self._query_records["key"][first:], first):
+            key = key.tobytes()
+            self._query_cache[key] = row
+            self._query_cache.move_to_end(key)
+        while len(self._query_cache) > QUERY_CACHE_SIZE:
+            self._query_cache.popitem(last=False)
+
+    def _save_query_cache(self):
+        """Append this process's new query embeddings, rewriting the file only when it has grown too far."""
+        new_keys = [key for key in self._new_query_keys if isinstance(self._query_cache.get(key), np.ndarray)]
+        self._new_query_keys = []
+        if not new_keys:
+            return
+        dim = self._query_cache[new_keys[0]].shape[0]
+        dtype = _query_record_dtype(dim)
+
+        def records(keys):
+            out = np.zeros(len(keys), dtype=dtype)
+            out["key"] = np.frombuffer(b"".join(keys), dtype=np.uint8).reshape(-1, 32)
+            out["vector"] = np.stack([self._query_cache[key] for key in keys])
+            out["checksum"] = np.frombuffer(b"".join(
+                _query_record_checksum(key, vector) for key, vector in zip(keys, out["vector"])), dtype=np.uint8).reshape(-1, 8)
+            return out.tobytes()
+
+        path = self._snapshot_path(QUERY_CACHE_FILE)
+        if (self._query_file_rows is not None and self._query_file_dim == dim
+                and self._query_file_rows + len(new_keys) <= QUERY_CACHE_SIZE * 2):
+            with open(path, "ab") as f:
+                size = f.seek(0, os.SEEK_END)
+                if size >= QUERY_CACHE_HEADER.size:
+                    # Drop a record torn by an earlier crash, so this append stays aligned. Appends
+                    # from concurrent searches can interleave, but each lands as whole records.
+                    torn = (size - QUERY_CACHE_HEADER.size) % dtype.itemsize
+                    if torn:
+                        f.truncate(size - torn)
+                    f.write(records(new_keys))
+                    self._query_file_rows += len(new_keys)
+                    return
+
+        # Missing, unreadable or grown to twice the cache: rewrite it from what this process holds.
+        keys = [key for key in list(self._query_cache) if self._cached_query_vector(key) is not None]
+        header = QUERY_CACHE_HEADER.pack(QUERY_CACHE_MAGIC, SNAPSHOT_VERSION, dim,
+                                         hashlib.sha256(MODEL_NAME.encode("utf-8")).digest())
+        data = records(keys)
+
+        def write(f):
+            f.write(header)
+            f.write(data)
+        self._write_atomic(QUERY_CACHE_FILE, write)
+        self._query_file_rows = len(keys)
+        self._query_file_dim = dim
+
+    def _write_atomic(self, name: str, write):
+        # Written beside the target and renamed over it, so a reader never sees a partial file
+        # and a mapping held by another process keeps the old contents.
+        path = self._snapshot_path(name)
+        temp_path = f"{path}.{os.getpid()}.tmp"
+        try:
+            with open(temp_path, "wb") as f:
+                write(f)
+            os.replace(temp_path, path)
+        except OSError:
+            if os.path.exists(temp_path):
+                os.remove(temp_path)
+            raise
+
+    def save_snapshot(self):
+        """
+        Write whatever changed in this process to the warm-start snapshot.
+
+        A search process only appends the query embeddings it computed, a few kilobytes, rather
+        than rewriting the cache.
+        """
+        if not self.snapshot_directory:
+            return
+        try:
+            os.makedirs(self.snapshot_directory, exist_ok=True)
+            if self._matrix is not None and not self._matrix_from_snapshot:
+                manifest = {
+                    "version": SNAPSHOT_VERSION,
+                    "store_fingerprint": self._get_store_fingerprint(),
+                    "count": int(self._matrix.shape[0]),
+                    "dim": int(self._matrix.shape[1]),
+                    "space": self._space,
+                }
+                self._write_atomic("matrix.npy", lambda f: np.save(f, np.ascontiguousarray(self._matrix, dtype=np.float32)))
+                documents = {"documents": self._documents, "metadatas": self._metadatas}
+                self._write_atomic("documents.json", lambda f: f.write(json.dumps(documents).encode("utf-8")))
+                # The manifest goes last; without it the other files are never trusted.
+                self._write_atomic("manifest.json", lambda f: f.write(json.dumps(manifest).encode("utf-8")))
+                self._matrix_from_snapshot = True
+            self._save_query_cache()
+        except OSError:
+            # A read-only or full disk only costs the next process its warm start.
+            pass
+
+    def warm_start(self) -> str:
+        """
+        Make sure a valid snapshot exists, building it from the store if needed.
+
+        Returns:
+            str: The store fingerprint the snapshot was validated against
+        """
+        if not self._matrix_from_snapshot:
+            self._load_matrix()
+            self.save_snapshot()
+        return self._get_store_fingerprint()
+
     def format_results(self, results: List[Dict]) -> str:
         """
         Format search results into a readable string.